@@ -29,7 +29,7 @@ void GroupedBoxplot::update_segmentation( QSharedPointer<const Segmentation> seg
         if( _segmentation = segmentation )
         {
             QObject::connect( segmentation.get(), &Segmentation::segment_count_changed, &_statistics, &ComputedObject::invalidate );
-            QObject::connect( segmentation.get(), &Segmentation::element_indices_changed, &_statistics, &ComputedObject::invalidate );
+            QObject::connect( segmentation.get(), &Segmentation::segment_numbers_changed, &_statistics, &ComputedObject::invalidate );
         }
         emit segmentation_changed( segmentation );
     }
@@ -72,28 +72,9 @@ Array<GroupedBoxplot::Statistics> GroupedBoxplot::compute_statistics() const
     const auto segmentation = _segmentation.lock();
     const auto feature = _feature.lock();
 
-    if( segmentation && feature )
+    if( segmentation && feature && feature->element_count() == segmentation->element_count() )
     {
-        statistics = Array<Statistics> { segmentation->segment_count(), Statistics {} };
-
-        const auto& element_indices = segmentation->element_indices();
-        for( uint32_t segment_number = 0; segment_number < segmentation->segment_count(); ++segment_number )
-        {
-            auto element_filter_feature = ElementFilterFeature { feature, element_indices[segment_number] };
-            const auto& extremes = element_filter_feature.extremes();
-            const auto& moments = element_filter_feature.moments();
-            const auto& quantiles = element_filter_feature.quantiles();
-
-            statistics[segment_number] = Statistics {
-                extremes.minimum,
-                extremes.maximum,
-                moments.average,
-                moments.standard_deviation,
-                quantiles.lower_quartile,
-                quantiles.upper_quartile,
-                quantiles.median
-            };
-        }
+        statistics = statistics::compute_segment_statistics( *feature, *segmentation );
     }
 
     return statistics;
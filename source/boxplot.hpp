@@ -1,4 +1,5 @@
 #pragma once
+#include "statistics.hpp"
 #include "utility.hpp"
 
 #include <qobject.h>
@@ -13,16 +14,7 @@ class GroupedBoxplot : public QObject
 {
     Q_OBJECT
 public:
-    struct Statistics
-    {
-        double minimum = 0.0;
-        double maximum = 0.0;
-        double average = 0.0;
-        double standard_deviation = 0.0;
-        double lower_quartile = 0.0;
-        double upper_quartile = 0.0;
-        double median = 0.0;
-    };
+    using Statistics = GroupStatistics;
 
     GroupedBoxplot();
 
@@ -48,17 +48,19 @@ void BoxplotViewer::update_feature( QSharedPointer<Feature> feature )
     {
         if( auto feature = _feature.lock() )
         {
-            QObject::disconnect( feature.get(), &Feature::values_changed, this, nullptr );
+            QObject::disconnect( feature.get(), nullptr, this, nullptr );
         }
 
         if( _feature = feature )
         {
             QObject::connect( feature.get(), &Feature::extremes_changed, this, &BoxplotViewer::on_feature_extremes_changed );
             QObject::connect( feature.get(), &Feature::moments_changed, this, &BoxplotViewer::on_feature_extremes_changed );
+            QObject::connect( feature.get(), &Feature::quantiles_changed, this, qOverload<>( &QWidget::update ) );
             this->on_feature_extremes_changed();
         }
 
         _boxplot.update_feature( feature );
+        _feature_residency.reset( feature ? &feature->computed_values() : nullptr );
     }
 }
 
@@ -172,8 +174,7 @@ void BoxplotViewer::paintEvent( QPaintEvent* event )
     {
         if( const auto feature = _feature.lock() )
         {
-            const auto& feature_values = feature->values();
-            const auto yscreen = this->world_to_screen_y( feature_values[*element_index] );
+            const auto yscreen = this->world_to_screen_y( feature->value( *element_index ) );
             painter.setPen( QPen { QColor { config::palette[500] }, 1.0, Qt::DashLine } );
             painter.drawLine(
                 QPointF { static_cast<double>( content_rectangle.left() ), yscreen },
@@ -362,6 +363,11 @@ void BoxplotViewer::export_boxplots() const
                 moments.average, moments.standard_deviation,
                 quantiles.lower_quartile, quantiles.upper_quartile, quantiles.median
             );
+
+            if( quantiles.rank_error > 0.0 )
+            {
+                Console::info( std::format( "Exported dataset quartiles are approximate (rank error {:.4f})", quantiles.rank_error ) );
+            }
         }
 
         const auto segmentation = _database.segmentation();
@@ -371,7 +377,7 @@ void BoxplotViewer::export_boxplots() const
             const auto segment = segmentation->segment( segment_number );
             const auto& statistics = segmentation_statistics[segment_number];
             write_boxplot(
-                segment->identifier(), segment->element_count(),
+                segment->identifier(), statistics.element_count,
                 statistics.minimum, statistics.maximum,
                 statistics.average, statistics.standard_deviation,
                 statistics.lower_quartile, statistics.upper_quartile, statistics.median
@@ -25,6 +25,7 @@ private:
     Database& _database;
     QWeakPointer<Feature> _feature;
     GroupedBoxplot _boxplot;
+    CacheResidency _feature_residency;
 
     QPointF _cursor_position;
 };
\ No newline at end of file
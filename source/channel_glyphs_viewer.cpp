@@ -798,7 +798,7 @@ void ChannelGlyphsViewer::mousePressEvent( QMouseEvent* event )
 
             auto action = viewport_menu->addAction( QIcon { pixmap }, segment->identifier(), [this, segment_number, spatial_metadata, &element_indices]
             {
-                const auto& indices = element_indices.value( segment_number );
+                const auto indices = element_indices.group( segment_number );
                 if( indices.empty() )
                 {
                     QMessageBox::warning( this, "", "The selected segment is empty." );
@@ -1081,7 +1081,8 @@ void ChannelGlyphsViewer::on_create_distance_matrix()
         auto element_indices = std::vector<uint32_t> {};
         if( const auto segment = segment_selector->selected_segment() )
         {
-            element_indices = segmentation->element_indices()[segment->number()];
+            const auto segment_indices = segmentation->element_indices().group( segment->number() );
+            element_indices.assign( segment_indices.begin(), segment_indices.end() );
         }
         else
         {
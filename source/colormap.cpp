@@ -1,15 +1,19 @@
 #include "colormap.hpp"
 
+#include "configuration.hpp"
 #include "embedding.hpp"
 #include "feature.hpp"
 #include "python.hpp"
 
+#include <array>
+#include <cstring>
 #include <numbers>
 
 // ----- ColormapTemplate ----- //
 
 ColormapTemplate::ColormapTemplate( std::vector<Node> nodes ) noexcept : _nodes { std::move( nodes ) }
 {
+    this->update_lookup_tables();
 }
 
 std::unique_ptr<ColormapTemplate> ColormapTemplate::clone() const
@@ -31,17 +35,15 @@ vec4<float> ColormapTemplate::color( double value ) const
     {
         return _nodes.back().color;
     }
-    for( size_t i = 1; i < _nodes.size(); ++i )
+    const auto node_b = std::upper_bound( _nodes.begin(), _nodes.end(), value, [] ( double value, const Node& node ) { return value < node.position; } );
+    if( node_b == _nodes.end() )
     {
-        if( value < _nodes[i].position )
-        {
-            const auto& node_a = _nodes[i - 1];
-            const auto& node_b = _nodes[i];
-            const auto t = ( value - node_a.position ) / ( node_b.position - node_a.position );
-            return node_a.color + t * ( node_b.color - node_a.color );
-        }
+        return vec4<float> { 0.0f, 0.0f, 0.0f, 0.0f };
     }
-    return vec4<float> { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    const auto node_a = std::prev( node_b );
+    const auto t = ( value - node_a->position ) / ( node_b->position - node_a->position );
+    return node_a->color + t * ( node_b->color - node_a->color );
 }
 void ColormapTemplate::invert()
 {
@@ -50,9 +52,39 @@ void ColormapTemplate::invert()
     {
         node.position = 1.0 - node.position;
     }
+    this->update_lookup_tables();
     emit colors_changed();
 }
 
+const std::vector<vec4<float>>& ColormapTemplate::lookup_table() const noexcept
+{
+    return _lookup_table;
+}
+const std::vector<uint32_t>& ColormapTemplate::packed_lookup_table() const noexcept
+{
+    return _packed_lookup_table;
+}
+
+void ColormapTemplate::update_lookup_tables()
+{
+    _lookup_table.resize( lookup_table_size );
+    _packed_lookup_table.resize( lookup_table_size );
+    for( uint32_t index = 0; index < lookup_table_size; ++index )
+    {
+        const auto color = this->color( static_cast<double>( index ) / ( lookup_table_size - 1 ) );
+        _lookup_table[index] = color;
+
+        const auto channel = [] ( float value ) { return static_cast<uint32_t>( std::clamp( value, 0.0f, 1.0f ) * 255.0f + 0.5f ); };
+        const auto bytes = std::array<uint8_t, 4> {
+            static_cast<uint8_t>( channel( color.r ) ),
+            static_cast<uint8_t>( channel( color.g ) ),
+            static_cast<uint8_t>( channel( color.b ) ),
+            static_cast<uint8_t>( channel( color.a ) )
+        };
+        std::memcpy( &_packed_lookup_table[index], bytes.data(), sizeof( uint32_t ) );
+    }
+}
+
 const ColormapTemplate ColormapTemplate::gray { std::vector<ColormapTemplate::Node> {
     { 0.0, vec4<float> { 0.0f, 0.0f, 0.0f, 1.0f } },
     { 1.0, vec4<float> { 1.0f, 1.0f, 1.0f, 1.0f } }
@@ -468,6 +500,32 @@ const Array<vec4<float>>& Colormap::colors() const
 {
     return *_colors;
 }
+const ComputedObject& Colormap::computed_colors() const noexcept
+{
+    return _colors;
+}
+bool Colormap::colors_present() const noexcept
+{
+    return _colors.present();
+}
+
+Array<vec4<float>> Colormap::sampled_colors( std::span<const uint32_t> element_indices ) const
+{
+    return _colors.present() ? Colormap::compute_sampled_colors( element_indices ) : this->compute_sampled_colors( element_indices );
+}
+void Colormap::refine()
+{}
+
+Array<vec4<float>> Colormap::compute_sampled_colors( std::span<const uint32_t> element_indices ) const
+{
+    const auto& colors = this->colors();
+    auto sampled_colors = Array<vec4<float>>::allocate( element_indices.size() );
+    utility::iterate_parallel( static_cast<uint32_t>( element_indices.size() ), [&] ( uint32_t sample_index )
+    {
+        sampled_colors[sample_index] = colors[element_indices[sample_index]];
+    } );
+    return sampled_colors;
+}
 
 // ----- Colormap1D ----- //
 
@@ -580,14 +638,53 @@ Override<double>& Colormap1D::upper() noexcept
     return _upper;
 }
 
+void Colormap1D::refine()
+{
+    if( _approximate_bounds )
+    {
+        this->update_automatic_bounds( true );
+    }
+}
+
 void Colormap1D::on_feature_extremes_changed()
+{
+    this->update_automatic_bounds( false );
+}
+void Colormap1D::update_automatic_bounds( bool exact )
 {
     if( auto feature = _feature.lock() )
     {
         const auto lower_override = _lower.override_value();
         const auto upper_override = _upper.override_value();
 
-        const auto& extremes = feature->extremes();
+        // Large features that are not computed yet take their bounds from an evenly strided sample until refined
+        _approximate_bounds = !exact && !feature->values_present() && feature->element_count() > config::progressive_preview_element_count;
+
+        auto extremes = Feature::Extremes { 0.0, 0.0 };
+        if( _approximate_bounds )
+        {
+            const auto stride = ( feature->element_count() + config::progressive_preview_element_count - 1 ) / config::progressive_preview_element_count;
+            auto element_indices = std::vector<uint32_t> {};
+            element_indices.reserve( feature->element_count() / stride + 1 );
+            for( uint32_t element_index = 0; element_index < feature->element_count(); element_index += stride )
+            {
+                element_indices.push_back( element_index );
+            }
+
+            extremes = Feature::Extremes { std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest() };
+            std::visit( [&extremes] ( const auto& values )
+            {
+                for( const auto value : values )
+                {
+                    extremes.minimum = std::min( extremes.minimum, static_cast<double>( value ) );
+                    extremes.maximum = std::max( extremes.maximum, static_cast<double>( value ) );
+                }
+            }, feature->sampled_values( element_indices ) );
+        }
+        else
+        {
+            extremes = feature->extremes();
+        }
         _lower.update_automatic_value( extremes.minimum );
         _upper.update_automatic_value( extremes.maximum );
 
@@ -596,6 +693,7 @@ void Colormap1D::on_feature_extremes_changed()
     }
     else
     {
+        _approximate_bounds = false;
         _lower.update_automatic_value( 0.0 );
         _upper.update_automatic_value( 0.0 );
     }
@@ -607,28 +705,29 @@ Array<vec4<float>> Colormap1D::compute_colors() const
 
     if( const auto feature = _feature.lock() )
     {
-        const auto& feature_values = feature->values();
-
         const auto lower = _lower.value();
         const auto upper = _upper.value();
 
-        if( lower == upper )
+        feature->visit_values( [this, &colors, lower, upper] ( const auto& feature_values )
         {
-            utility::iterate_parallel( this->element_count(), [this, &colors] ( uint32_t element_index )
-            {
-                colors[element_index] = _colormap_template->color( 0.5 );
-            } );
-        }
-        else
+            _colormap_template->apply( std::span { feature_values.data(), feature_values.size() }, lower, upper, colors.data() );
+        } );
+    }
+
+    return colors;
+}
+
+Array<vec4<float>> Colormap1D::compute_sampled_colors( std::span<const uint32_t> element_indices ) const
+{
+    const auto sample_count = static_cast<uint32_t>( element_indices.size() );
+    auto colors = Array<vec4<float>> { sample_count, vec4<float> { 0.0f, 0.0f, 0.0f, 1.0f } };
+
+    if( const auto feature = _feature.lock() )
+    {
+        std::visit( [&] ( const auto& feature_values )
         {
-            const auto range = upper - lower;
-            utility::iterate_parallel( this->element_count(), [this, &colors, &feature_values, lower, range] ( uint32_t element_index )
-            {
-                const auto value = feature_values[element_index];
-                const auto normalized = ( value - lower ) / range;
-                colors[element_index] = _colormap_template->color( normalized );
-            } );
-        }
+            _colormap_template->apply( std::span { feature_values.data(), feature_values.size() }, _lower.value(), _upper.value(), colors.data() );
+        }, feature->sampled_values( element_indices ) );
     }
 
     return colors;
@@ -682,6 +781,27 @@ Array<vec4<float>> ColormapRGB::compute_colors() const
     return colors;
 }
 
+void ColormapRGB::refine()
+{
+    _colormap_r.refine();
+    _colormap_g.refine();
+    _colormap_b.refine();
+}
+
+Array<vec4<float>> ColormapRGB::compute_sampled_colors( std::span<const uint32_t> element_indices ) const
+{
+    const auto colors_r = _colormap_r.sampled_colors( element_indices );
+    const auto colors_g = _colormap_g.sampled_colors( element_indices );
+    const auto colors_b = _colormap_b.sampled_colors( element_indices );
+
+    auto colors = Array<vec4<float>>::allocate( element_indices.size() );
+    utility::iterate_parallel( static_cast<uint32_t>( element_indices.size() ), [&] ( uint32_t sample_index )
+    {
+        colors[sample_index] = vec4<float> { colors_r[sample_index].r, colors_g[sample_index].g, colors_b[sample_index].b, 1.0f };
+    } );
+    return colors;
+}
+
 // ----- ColormapEmbedding ----- //
 
 ColormapEmbedding::ColormapEmbedding( uint32_t element_count ) : _element_count { element_count }
@@ -33,19 +33,55 @@ public:
         vec4<float> color;
     };
 
+    static constexpr auto lookup_table_size = uint32_t { 4096 };
+
     ColormapTemplate( std::vector<Node> nodes ) noexcept;
     std::unique_ptr<ColormapTemplate> clone() const;
 
     vec4<float> color( double value ) const;
     void invert();
 
+    // Colors sampled evenly over [0, 1], the packed variant holds RGBA8888 bytes in memory order
+    const std::vector<vec4<float>>& lookup_table() const noexcept;
+    const std::vector<uint32_t>& packed_lookup_table() const noexcept;
+
+    // Normalizes values to [lower, upper] and gathers their nearest lookup table entries, NaN values map to transparent
+    template<class T, class C> void apply( std::span<const T> values, double lower, double upper, C* colors ) const;
+
 private:
+    void update_lookup_tables();
+
     std::vector<Node> _nodes;
+    std::vector<vec4<float>> _lookup_table;
+    std::vector<uint32_t> _packed_lookup_table;
 
 signals:
     void colors_changed();
 };
 
+template<class T, class C> void ColormapTemplate::apply( std::span<const T> values, double lower, double upper, C* colors ) const
+{
+    static_assert( std::is_same_v<C, vec4<float>> || std::is_same_v<C, uint32_t>, "Colors are either float or packed RGBA8888" );
+    const auto& lookup_table = [this] () -> const auto&
+    {
+        if constexpr( std::is_same_v<C, uint32_t> ) return _packed_lookup_table;
+        else return _lookup_table;
+    }();
+
+    // Equal bounds map everything to the center, like the interpolated colors
+    const auto maximum_index = static_cast<float>( lookup_table_size - 1 );
+    const auto scale = upper == lower ? 0.0 : maximum_index / ( upper - lower );
+    const auto offset = upper == lower ? 0.5 * maximum_index : -lower * scale;
+
+    // Branch-free loop body, so the normalization and the gather vectorize
+    utility::iterate_parallel( static_cast<uint32_t>( values.size() ), [&] ( uint32_t index )
+    {
+        const auto value = static_cast<float>( static_cast<double>( values[index] ) * scale + offset );
+        const auto clamped = value > 0.0f ? ( value < maximum_index ? value + 0.5f : maximum_index ) : 0.0f;
+        colors[index] = value == value ? lookup_table[static_cast<uint32_t>( clamped )] : C {};
+    } );
+}
+
 // ----- Colormap ---- //
 
 class Colormap : public QObject
@@ -56,12 +92,19 @@ public:
 
     virtual uint32_t element_count() const = 0;
     const Array<vec4<float>>& colors() const;
+    const ComputedObject& computed_colors() const noexcept;
+    bool colors_present() const noexcept;
+
+    // Colors of a subset of elements for previews, refine replaces approximations made for them
+    Array<vec4<float>> sampled_colors( std::span<const uint32_t> element_indices ) const;
+    virtual void refine();
 
 signals:
     void colors_changed() const;
 
 protected:
     virtual Array<vec4<float>> compute_colors() const = 0;
+    virtual Array<vec4<float>> compute_sampled_colors( std::span<const uint32_t> element_indices ) const;
     Computed<Array<vec4<float>>> _colors;
 };
 
@@ -87,19 +130,24 @@ public:
     const Override<double>& upper() const noexcept;
     Override<double>& upper() noexcept;
 
+    void refine() override;
+
 signals:
     void template_changed( const std::unique_ptr<ColormapTemplate>& colormap_template );
     void feature_changed( QSharedPointer<Feature> feature );
 
 private:
     void on_feature_extremes_changed();
+    void update_automatic_bounds( bool exact );
 
     Array<vec4<float>> compute_colors() const override;
+    Array<vec4<float>> compute_sampled_colors( std::span<const uint32_t> element_indices ) const override;
 
     std::unique_ptr<ColormapTemplate> _colormap_template;
     QWeakPointer<Feature> _feature;
     Override<double> _lower { 0.0, std::nullopt };
     Override<double> _upper { 1.0, std::nullopt };
+    bool _approximate_bounds = false;
 };
 
 // ----- ColormapRGB ---- //
@@ -116,8 +164,11 @@ public:
     const Colormap1D& colormap_g() const noexcept;
     const Colormap1D& colormap_b() const noexcept;
 
+    void refine() override;
+
 private:
     Array<vec4<float>> compute_colors() const override;
+    Array<vec4<float>> compute_sampled_colors( std::span<const uint32_t> element_indices ) const override;
     Colormap1D _colormap_r { ColormapTemplate::red.clone() };
     Colormap1D _colormap_g { ColormapTemplate::green.clone() };
     Colormap1D _colormap_b { ColormapTemplate::blue.clone() };
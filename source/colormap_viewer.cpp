@@ -17,6 +17,8 @@
 #include <qspinbox.h>
 #include <qtoolbutton.h>
 
+#include <numeric>
+
 // ----- Colormap1DPreview ----- //
 
 Colormap1DPreview::Colormap1DPreview( Colormap1D& colormap ) : QWidget {}, _colormap { colormap }
@@ -43,12 +45,9 @@ void Colormap1DPreview::paintEvent( QPaintEvent* event )
 
     auto colormap_rectangle = border_rectangle.marginsRemoved( QMargins { 1, 0, 0, 0 } );
     auto colormap_image = QImage { colormap_rectangle.width(), 1, QImage::Format_RGBA8888 };
-    for( int x = 0; x < colormap_image.width(); ++x )
-    {
-        const auto value = static_cast<double>( x ) / ( colormap_image.width() - 1 );
-        const auto color = _colormap.colormap_template()->color( value ).qcolor();
-        colormap_image.setPixelColor( x, 0, color );
-    }
+    auto positions = std::vector<float>( colormap_image.width() );
+    std::iota( positions.begin(), positions.end(), 0.0f );
+    _colormap.colormap_template()->apply( std::span<const float> { positions }, 0.0, colormap_image.width() - 1.0, reinterpret_cast<uint32_t*>( colormap_image.scanLine( 0 ) ) );
 
     painter.setRenderHint( QPainter::Antialiasing, false );
     painter.drawImage( colormap_rectangle, colormap_image );
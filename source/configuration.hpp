@@ -9,7 +9,7 @@ namespace config
     {
         uint8_t major = 1;
         uint8_t minor = 0;
-        uint8_t patch = 6;
+        uint8_t patch = 7;
 
         bool operator==( const ApplicationVersion& other ) const noexcept
         {
@@ -44,13 +44,21 @@ namespace config
     };
 
     constexpr inline ApplicationVersion application_version;
-    constexpr inline auto application_version_string = "1.0.6";
+    constexpr inline auto application_version_string = "1.0.7";
     constexpr inline auto application_identifier = "multiscale-image-analysis";
     constexpr inline auto application_display_name = "MIA: Multiscale Image Analysis";
 
     constexpr inline auto developer_version = true;
     constexpr inline auto logger_console_enabled = true;
 
+    constexpr inline auto cache_budget_fraction = 0.5;
+    constexpr inline auto quantile_sketch_k = uint32_t { 200 };
+    constexpr inline auto segmentation_block_size = uint32_t { 1 } << 20;
+    constexpr inline auto connected_component_minimum_size = uint32_t { 16 };
+    constexpr inline auto segmentation_history_budget = size_t { 256 } * 1024 * 1024;
+    constexpr inline auto progressive_preview_element_count = uint32_t { 1 } << 20;
+    constexpr inline auto progressive_refine_delay = 250;
+
     static inline auto font = QFont { "sans-serif", 10, -1 };
     static inline auto palette = std::unordered_map<int, const char*> {
         { 50, "#FAFAFA" },
@@ -0,0 +1,286 @@
+#include "connectivity.hpp"
+
+#include "dataset.hpp"
+#include "segmentation.hpp"
+
+#include <atomic>
+#include <numeric>
+#include <thread>
+
+namespace
+{
+    uint32_t chunk_count( uint32_t work_count, uint32_t minimum_chunk_size )
+    {
+        return std::clamp( work_count / minimum_chunk_size, 1u, std::max( std::thread::hardware_concurrency(), 1u ) );
+    }
+
+    uint32_t find_root( uint32_t* parents, uint32_t element_index )
+    {
+        while( parents[element_index] != element_index )
+        {
+            element_index = parents[element_index] = parents[parents[element_index]];
+        }
+        return element_index;
+    }
+    uint32_t find_root( const uint32_t* parents, uint32_t element_index )
+    {
+        while( parents[element_index] != element_index )
+        {
+            element_index = parents[element_index];
+        }
+        return element_index;
+    }
+
+    void unite( uint32_t* parents, uint32_t first, uint32_t second )
+    {
+        // Roots are linked towards the smaller index, so trees of a row band never leave the band
+        first = find_root( parents, first );
+        second = find_root( parents, second );
+        if( first < second ) parents[second] = first;
+        else if( second < first ) parents[first] = second;
+    }
+}
+
+namespace connectivity
+{
+    ConnectedComponents label_components( std::span<const uint32_t> values, vec2<uint32_t> dimensions )
+    {
+        const auto width = dimensions.x;
+        const auto height = dimensions.y;
+        const auto band_count = chunk_count( height, 64 );
+        const auto band_height = ( height + band_count - 1 ) / band_count;
+
+        const auto band_range = [=] ( uint32_t band_index )
+        {
+            const auto begin = std::min( band_index * band_height, height );
+            return std::pair { begin, std::min( begin + band_height, height ) };
+        };
+
+        auto parents = Array<uint32_t>::allocate( values.size() );
+        std::iota( parents.begin(), parents.end(), 0u );
+
+        // Union-find within independent row bands, followed by the seams between consecutive bands
+        utility::iterate_parallel( band_count, [&] ( uint32_t band_index )
+        {
+            const auto [begin, end] = band_range( band_index );
+            for( auto y = begin; y < end; ++y )
+            {
+                for( uint32_t x = 0; x < width; ++x )
+                {
+                    const auto element_index = y * width + x;
+                    if( x > 0 && values[element_index - 1] == values[element_index] )
+                    {
+                        unite( parents.data(), element_index - 1, element_index );
+                    }
+                    if( y > begin && values[element_index - width] == values[element_index] )
+                    {
+                        unite( parents.data(), element_index - width, element_index );
+                    }
+                }
+            }
+        } );
+
+        for( uint32_t band_index = 1; band_index < band_count; ++band_index )
+        {
+            const auto y = band_range( band_index ).first;
+            for( uint32_t x = 0; y < height && x < width; ++x )
+            {
+                const auto element_index = y * width + x;
+                if( values[element_index - width] == values[element_index] )
+                {
+                    unite( parents.data(), element_index - width, element_index );
+                }
+            }
+        }
+
+        // Roots are numbered by band, then every element resolves its root without modifying the forest
+        auto band_offsets = std::vector<uint32_t>( band_count + 1, 0 );
+        utility::iterate_parallel( band_count, [&] ( uint32_t band_index )
+        {
+            const auto [begin, end] = band_range( band_index );
+            for( auto element_index = begin * width; element_index < end * width; ++element_index )
+            {
+                band_offsets[band_index + 1] += parents[element_index] == element_index;
+            }
+        } );
+        std::partial_sum( band_offsets.begin(), band_offsets.end(), band_offsets.begin() );
+
+        auto components = ConnectedComponents {
+            .labels = Array<uint32_t>::allocate( values.size() ),
+            .component_count = band_offsets.back()
+        };
+
+        utility::iterate_parallel( band_count, [&] ( uint32_t band_index )
+        {
+            const auto [begin, end] = band_range( band_index );
+            auto label = band_offsets[band_index];
+            for( auto element_index = begin * width; element_index < end * width; ++element_index )
+            {
+                if( parents[element_index] == element_index )
+                {
+                    components.labels[element_index] = label++;
+                }
+            }
+        } );
+
+        const auto* roots = parents.data();
+        utility::iterate_parallel( band_count, [&] ( uint32_t band_index )
+        {
+            const auto [begin, end] = band_range( band_index );
+            for( auto element_index = begin * width; element_index < end * width; ++element_index )
+            {
+                if( const auto root = find_root( roots, element_index ); root != element_index )
+                {
+                    components.labels[element_index] = components.labels[root];
+                }
+            }
+        } );
+
+        return components;
+    }
+
+    uint32_t split_segment( const Dataset& dataset, Segmentation& segmentation, uint32_t segment_number, uint32_t minimum_size )
+    {
+        const auto spatial_metadata = dataset.spatial_metadata();
+        if( !spatial_metadata || segment_number == 0 || segment_number >= segmentation.segment_count() )
+        {
+            return 0;
+        }
+
+        const auto& segment_numbers = segmentation.segment_numbers();
+        const auto components = label_components( std::span { segment_numbers.data(), segment_numbers.size() }, spatial_metadata->dimensions );
+
+        auto component_sizes = std::vector<uint32_t>( components.component_count, 0 );
+        for( uint32_t element_index = 0; element_index < segmentation.element_count(); ++element_index )
+        {
+            if( segment_numbers[element_index] == segment_number )
+            {
+                ++component_sizes[components.labels[element_index]];
+            }
+        }
+
+        const auto largest_component = static_cast<uint32_t>( std::max_element( component_sizes.begin(), component_sizes.end() ) - component_sizes.begin() );
+
+        auto component_segment_numbers = std::vector<uint32_t>( components.component_count, segment_number );
+        auto split_count = uint32_t { 0 };
+        for( uint32_t component = 0; component < components.component_count; ++component )
+        {
+            if( component != largest_component && component_sizes[component] > 0 && component_sizes[component] >= minimum_size )
+            {
+                component_segment_numbers[component] = segmentation.append_segment()->number();
+                ++split_count;
+            }
+        }
+
+        if( split_count )
+        {
+            auto editor = segmentation.editor();
+            for( uint32_t element_index = 0; element_index < segmentation.element_count(); ++element_index )
+            {
+                if( segment_numbers[element_index] == segment_number )
+                {
+                    editor.update_value( element_index, component_segment_numbers[components.labels[element_index]] );
+                }
+            }
+        }
+
+        Console::info( std::format( "Split segment {} into {} connected components", segment_number, split_count + 1 ) );
+        return split_count;
+    }
+
+    uint32_t grow_region( const Dataset& dataset, Segmentation& segmentation, uint32_t seed_element_index, uint32_t segment_number, double threshold )
+    {
+        const auto spatial_metadata = dataset.spatial_metadata();
+        if( !spatial_metadata || seed_element_index >= dataset.element_count() || segment_number >= segmentation.segment_count() )
+        {
+            return 0;
+        }
+
+        const auto width = spatial_metadata->width;
+        const auto height = spatial_metadata->height;
+        auto region = std::vector<uint32_t> { seed_element_index };
+
+        dataset.visit( [&] ( const auto& dataset )
+        {
+            const auto channel_count = dataset.channel_count();
+            const auto intensities = dataset.intensities().data();
+            const auto seed = intensities + size_t { seed_element_index } * channel_count;
+
+            auto seed_norm = 0.0;
+            for( uint32_t channel_index = 0; channel_index < channel_count; ++channel_index )
+            {
+                seed_norm += static_cast<double>( seed[channel_index] ) * seed[channel_index];
+            }
+            const auto maximum_distance = threshold * threshold * seed_norm;
+
+            const auto similar = [&] ( uint32_t element_index )
+            {
+                const auto element = intensities + size_t { element_index } * channel_count;
+                auto distance = 0.0;
+                for( uint32_t channel_index = 0; channel_index < channel_count && distance <= maximum_distance; ++channel_index )
+                {
+                    const auto difference = static_cast<double>( element[channel_index] ) - static_cast<double>( seed[channel_index] );
+                    distance += difference * difference;
+                }
+                return distance <= maximum_distance;
+            };
+
+            // Level-synchronous breadth-first search, each frontier is expanded in parallel chunks
+            auto visited = std::vector<std::atomic<uint8_t>>( dataset.element_count() );
+            visited[seed_element_index] = 1;
+
+            auto frontier = std::vector<uint32_t> { seed_element_index };
+            while( !frontier.empty() )
+            {
+                const auto frontier_size = static_cast<uint32_t>( frontier.size() );
+                const auto frontier_chunk_count = chunk_count( frontier_size, 1024 );
+                const auto frontier_chunk_size = ( frontier_size + frontier_chunk_count - 1 ) / frontier_chunk_count;
+
+                auto next_frontiers = std::vector<std::vector<uint32_t>>( frontier_chunk_count );
+                utility::iterate_parallel( frontier_chunk_count, [&] ( uint32_t chunk_index )
+                {
+                    const auto begin = std::min( chunk_index * frontier_chunk_size, frontier_size );
+                    const auto end = std::min( begin + frontier_chunk_size, frontier_size );
+
+                    auto& next_frontier = next_frontiers[chunk_index];
+                    const auto visit_neighbor = [&] ( uint32_t element_index )
+                    {
+                        if( !visited[element_index].exchange( 1 ) && similar( element_index ) )
+                        {
+                            next_frontier.push_back( element_index );
+                        }
+                    };
+
+                    for( auto index = begin; index < end; ++index )
+                    {
+                        const auto element_index = frontier[index];
+                        const auto x = element_index % width;
+                        const auto y = element_index / width;
+                        if( x > 0 ) visit_neighbor( element_index - 1 );
+                        if( x + 1 < width ) visit_neighbor( element_index + 1 );
+                        if( y > 0 ) visit_neighbor( element_index - width );
+                        if( y + 1 < height ) visit_neighbor( element_index + width );
+                    }
+                } );
+
+                frontier.clear();
+                for( const auto& next_frontier : next_frontiers )
+                {
+                    frontier.insert( frontier.end(), next_frontier.begin(), next_frontier.end() );
+                }
+                region.insert( region.end(), frontier.begin(), frontier.end() );
+            }
+        } );
+
+        {
+            auto editor = segmentation.editor();
+            for( const auto element_index : region )
+            {
+                editor.update_value( element_index, segment_number );
+            }
+        }
+
+        Console::info( std::format( "Grew region of {} elements from element {}", region.size(), seed_element_index ) );
+        return static_cast<uint32_t>( region.size() );
+    }
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+#include "utility.hpp"
+
+class Dataset;
+class Segmentation;
+
+// ----- ConnectedComponents ----- //
+
+struct ConnectedComponents
+{
+    Array<uint32_t> labels;
+    uint32_t component_count = 0;
+};
+
+namespace connectivity
+{
+    // Labels 4-connected components of equal values on a row-major grid
+    ConnectedComponents label_components( std::span<const uint32_t> values, vec2<uint32_t> dimensions );
+
+    // Moves every connected component of a segment except the largest into a new segment, smaller components than minimum_size stay in place
+    uint32_t split_segment( const Dataset& dataset, Segmentation& segmentation, uint32_t segment_number, uint32_t minimum_size );
+
+    // Assigns all elements 4-connected to the seed whose spectrum lies within a relative euclidean distance of the seed spectrum
+    uint32_t grow_region( const Dataset& dataset, Segmentation& segmentation, uint32_t seed_element_index, uint32_t segment_number, double threshold );
+}
\ No newline at end of file
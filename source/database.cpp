@@ -1,5 +1,7 @@
 #include "database.hpp"
 
+#include "connectivity.hpp"
+#include "morphology.hpp"
 #include "segmentation_creator.hpp"
 #include "segmentation_manager.hpp"
 #include "python.hpp"
@@ -108,6 +110,15 @@ void Database::update_highlighted_channel_index( std::optional<uint32_t> index )
     }
 }
 
+const SegmentMask& Database::selection() const noexcept
+{
+    return _selection;
+}
+void Database::update_selection( SegmentMask selection )
+{
+    _selection = std::move( selection );
+}
+
 void Database::populate_segmentation_menu( QMenu& context_menu, bool enable_propogate )
 {
     for( uint32_t segment_number = 1; segment_number < _segmentation->segment_count(); ++segment_number )
@@ -145,14 +156,46 @@ void Database::populate_segmentation_menu( QMenu& context_menu, bool enable_prop
 
     auto segmentation_menu = context_menu.addMenu( "Segmentation" );
     segmentation_menu->addAction( "Manage", [this] { SegmentationManager::execute( *this ); } );
+
+    auto undo_action = segmentation_menu->addAction( "Undo", _segmentation.get(), &Segmentation::undo );
+    undo_action->setShortcut( QKeySequence::Undo );
+    undo_action->setEnabled( _segmentation->undoable() );
+    auto redo_action = segmentation_menu->addAction( "Redo", _segmentation.get(), &Segmentation::redo );
+    redo_action->setShortcut( QKeySequence::Redo );
+    redo_action->setEnabled( _segmentation->redoable() );
+
     segmentation_menu->addAction( "Create", [this]
     {
         if( const auto segmentation = SegmentationCreator::execute( *this ) )
         {
-            _segmentation->deserialize( segmentation->serialize() );
+            _segmentation->assign( *segmentation );
         }
     } );
 
+    if( _dataset->spatial_metadata() )
+    {
+        segmentation_menu->addAction( "Split Connected Components", [this]
+        {
+            connectivity::split_segment( *_dataset, *_segmentation, this->active_segment()->number(), config::connected_component_minimum_size );
+        } );
+
+        auto morphology_menu = segmentation_menu->addMenu( "Morphology" );
+        const auto morphology_operations = std::vector<std::pair<const char*, morphology::Operation>> {
+            { "Dilate", morphology::Operation::eDilate },
+            { "Erode", morphology::Operation::eErode },
+            { "Open", morphology::Operation::eOpen },
+            { "Close", morphology::Operation::eClose },
+            { "Fill Holes", morphology::Operation::eFillHoles }
+        };
+        for( const auto [label, operation] : morphology_operations )
+        {
+            morphology_menu->addAction( label, [this, operation]
+            {
+                morphology::apply( *_dataset, *_segmentation, this->active_segment()->number(), operation );
+            } );
+        }
+    }
+
     if( enable_propogate )
     {
         segmentation_menu->addAction( "Propagate", [this]
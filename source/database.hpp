@@ -4,6 +4,7 @@
 #include "dataset.hpp"
 #include "embedding.hpp"
 #include "feature.hpp"
+#include "segment_mask.hpp"
 #include "segmentation.hpp"
 
 #include <qmenu.h>
@@ -35,6 +36,10 @@ public:
     std::optional<uint32_t> highlighted_channel_index() const noexcept;
     void update_highlighted_channel_index( std::optional<uint32_t> index );
 
+    // Elements covered by the last lasso or rectangle selection in the image viewer
+    const SegmentMask& selection() const noexcept;
+    void update_selection( SegmentMask selection );
+
     void populate_segmentation_menu( QMenu& context_menu, bool enable_propogate = false );
 
 signals:
@@ -56,4 +61,6 @@ private:
 
     std::optional<uint32_t> _highlighted_element_index;
     std::optional<uint32_t> _highlighted_channel_index;
+
+    SegmentMask _selection;
 };
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include <regex>
 #include <sstream>
 
+#include <qapplication.h>
 #include <qcheckbox.h>
 #include <qcombobox.h>
 #include <qfiledialog.h>
@@ -17,6 +18,34 @@
 #include <qmessagebox.h>
 #include <qpushbutton.h>
 
+namespace
+{
+    // Without dialogs errors are logged and questions take their default answer
+    void show_error( const QString& message )
+    {
+        if( DatasetImporter::interactive )
+        {
+            QMessageBox::critical( nullptr, "", message, QMessageBox::Ok );
+        }
+        else
+        {
+            Console::error( message.toStdString() );
+        }
+    }
+    bool ask_question( const QString& message, bool default_answer )
+    {
+        if( DatasetImporter::interactive )
+        {
+            return QMessageBox::question( nullptr, "", message ) == QMessageBox::Yes;
+        }
+
+        Console::info( std::format( "{} {}", message.toStdString(), default_answer ? "Yes" : "No" ) );
+        return default_answer;
+    }
+}
+
+bool DatasetImporter::interactive = true;
+
 QSharedPointer<Dataset> DatasetImporter::from_csv( const std::filesystem::path& filepath )
 {
     const auto filename = filepath.filename();
@@ -54,7 +83,7 @@ QSharedPointer<Dataset> DatasetImporter::from_csv( const std::filesystem::path&
         }
     }
 
-    QMessageBox::critical( nullptr, "", "Unsupported file format" );
+    show_error( "Unsupported file format" );
     return nullptr;
 }
 QSharedPointer<Dataset> DatasetImporter::from_data_dims_freq( const std::filesystem::path& input_filepath )
@@ -151,7 +180,7 @@ QSharedPointer<Dataset> DatasetImporter::from_data_dims_freq( const std::filesys
     default:
     {
         Console::error( "Invalid value type" );
-        QMessageBox::critical( nullptr, "", "Invalid value type", QMessageBox::Ok );
+        show_error( "Invalid value type" );
         return nullptr;
     }
     }
@@ -169,18 +198,58 @@ QSharedPointer<Dataset> DatasetImporter::from_hdf5( const std::filesystem::path&
         if( !tensor.dtype().is( py::dtype::of<float>() ) )
         {
             Console::error( "Unsupported data type: " + std::string { py::str { tensor.dtype() } } );
-            QMessageBox::critical( nullptr, "", "Unsupported data type", QMessageBox::Ok );
+            show_error( "Unsupported data type" );
             return nullptr;
         }
 
         auto shape = py::tuple { tensor.attr( "shape" ) };
-        auto dimensions = new QComboBox {};
+        auto widths = std::vector<uint32_t> {};
         for( uint32_t i = 1; i <= shape[0].cast<uint32_t>(); ++i )
         {
             if( shape[0].cast<double>() / i == shape[0].cast<uint32_t>() / i )
             {
-                dimensions->addItem( QString::number( i ) + " x " + QString::number( shape[0].cast<uint32_t>() / i ), i );
+                widths.push_back( i );
+            }
+        }
+
+        const auto create_dataset = [&] ( uint32_t width, double channels_lower, double channels_upper )
+        {
+            const auto dimensions = vec3<uint32_t> {
+                width,
+                shape[0].cast<uint32_t>() / width,
+                shape[1].cast<uint32_t>()
+            };
+
+            auto intensities = Matrix<float>::from_pointer(
+                { shape[0].cast<uint32_t>(), shape[1].cast<uint32_t>() },
+                static_cast<float*>( tensor.mutable_data() )
+            );
+            tensor.release();
+
+            auto channels = Array<double> { shape[1].cast<uint32_t>(), 0.0 };
+            const auto stepsize = ( channels_upper - channels_lower ) / ( channels.size() - 1 );
+            for( uint32_t i = 0; i < channels.size(); ++i )
+            {
+                channels.value( i ) = std::clamp( channels_lower + i * stepsize, channels_lower, channels_upper );
             }
+
+            auto dataset = QSharedPointer<Dataset> { new TensorDataset { std::move( intensities ), std::move( channels ) } };
+            dataset->update_spatial_metadata( std::make_unique<Dataset::SpatialMetadata>( dimensions.x, dimensions.y ) );
+            return dataset;
+        };
+
+        // Without dialogs the preselected dimensions and the full channel range are imported
+        if( !DatasetImporter::interactive )
+        {
+            const auto width = widths[widths.size() / 2];
+            Console::info( std::format( "Importing with dimensions {} x {}", width, shape[0].cast<uint32_t>() / width ) );
+            return create_dataset( width, 1.0, shape[1].cast<double>() );
+        }
+
+        auto dimensions = new QComboBox {};
+        for( const auto width : widths )
+        {
+            dimensions->addItem( QString::number( width ) + " x " + QString::number( shape[0].cast<uint32_t>() / width ), width );
         }
         dimensions->setCurrentIndex( dimensions->count() / 2 );
 
@@ -209,28 +278,7 @@ QSharedPointer<Dataset> DatasetImporter::from_hdf5( const std::filesystem::path&
 
         QObject::connect( button_import, &QPushButton::clicked, [&]
         {
-            const auto width = static_cast<uint32_t>( dimensions->currentData().toInt() );
-            const auto dimensions = vec3<uint32_t> {
-                width,
-                shape[0].cast<uint32_t>() / width,
-                shape[1].cast<uint32_t>()
-            };
-
-            auto intensities = Matrix<float>::from_pointer(
-                { shape[0].cast<uint32_t>(), shape[1].cast<uint32_t>() },
-                static_cast<float*>( tensor.mutable_data() )
-            );
-            tensor.release();
-
-            auto channels = Array<double> { shape[1].cast<uint32_t>(), 0.0 };
-            const auto stepsize = ( channels_upper->value() - channels_lower->value() ) / ( channels.size() - 1 );
-            for( uint32_t i = 0; i < channels.size(); ++i )
-            {
-                channels.value( i ) = std::clamp( channels_lower->value() + i * stepsize, channels_lower->value(), channels_upper->value() );
-            }
-
-            dataset.reset( new TensorDataset { std::move( intensities ), std::move( channels ) } );
-            dataset->update_spatial_metadata( std::make_unique<Dataset::SpatialMetadata>( dimensions.x, dimensions.y ) );
+            dataset = create_dataset( static_cast<uint32_t>( dimensions->currentData().toInt() ), channels_lower->value(), channels_upper->value() );
             dialog.accept();
         } );
 
@@ -242,7 +290,7 @@ QSharedPointer<Dataset> DatasetImporter::from_hdf5( const std::filesystem::path&
     catch( const py::error_already_set& error )
     {
         Console::error( std::format( "Python error during dataset import: {}", error.what() ) );
-        QMessageBox::critical( nullptr, "", "Failed to import dataset", QMessageBox::Ok );
+        show_error( "Failed to import dataset" );
     }
 
     return nullptr;
@@ -317,7 +365,7 @@ QSharedPointer<Dataset> DatasetImporter::from_matrix( const std::filesystem::pat
 
         if( lines.empty() )
         {
-            QMessageBox::critical( nullptr, "", "Failed to import dataset: empty file" );
+            show_error( "Failed to import dataset: empty file" );
             return nullptr;
         }
 
@@ -339,7 +387,7 @@ QSharedPointer<Dataset> DatasetImporter::from_matrix( const std::filesystem::pat
             if( false && current_dimensions != dimensions )
             {
                 Console::error( std::format( "File {} has incompatible dimensions ({} x {})", filepath.filename().string(), current_dimensions.x, current_dimensions.y ) );
-                QMessageBox::critical( nullptr, "", "Failed to import dataset: incompatible dimensions" );
+                show_error( "Failed to import dataset: incompatible dimensions" );
                 return nullptr;
             }
         }
@@ -382,7 +430,7 @@ QSharedPointer<Dataset> DatasetImporter::from_mia( const std::filesystem::path&
     if( !stream )
     {
         Console::error( "Failed to open file: " + filepath.string() );
-        QMessageBox::critical( nullptr, "", "Failed to open file" );
+        show_error( "Failed to open file" );
         return nullptr;
     }
     return stream.read<QSharedPointer<Dataset>>();
@@ -533,7 +581,7 @@ QSharedPointer<Dataset> DatasetImporter::from_laser_info( const std::filesystem:
     if( laser_lines[0].line != 1 )
     {
         Console::error( "Invalid line number encountered: " + std::to_string( laser_lines[0].line ) );
-        QMessageBox::critical( nullptr, "", "Invalid line number encountered" );
+        show_error( "Invalid line number encountered" );
         return nullptr;
     }
 
@@ -542,7 +590,7 @@ QSharedPointer<Dataset> DatasetImporter::from_laser_info( const std::filesystem:
         if( laser_line.line_type != 0 )
         {
             Console::error( "Unsupported line type encountered: " + std::to_string( laser_line.line_type ) );
-            QMessageBox::critical( nullptr, "", "Unsupported line type encountered" );
+            show_error( "Unsupported line type encountered" );
             return nullptr;
         }
     }
@@ -556,26 +604,25 @@ QSharedPointer<Dataset> DatasetImporter::from_laser_info( const std::filesystem:
 
         if( current.line != previous.line + 1 )
         {
-            QMessageBox::critical( nullptr, "", "Invalid line number encountered" );
+            show_error( "Invalid line number encountered" );
             return nullptr;
         }
 
         if( current.spot_spacing != previous.spot_spacing )
         {
-            QMessageBox::critical( nullptr, "", "Varying spot spacing not supported" );
+            show_error( "Varying spot spacing not supported" );
             return nullptr;
         }
 
         if( current.spot_size != previous.spot_size )
         {
-            QMessageBox::critical( nullptr, "", "Varying spot size not supported" );
+            show_error( "Varying spot size not supported" );
             return nullptr;
         }
 
         if( !ignore_invalid_vertical_spacing && std::abs( current.start_y - ( previous.start_y + current.spot_size ) ) > 1.0e-6 )
         {
-            const auto result = QMessageBox::critical( nullptr, "", "Vertical spacing must be equal to spot size", QMessageBox::Abort | QMessageBox::Ignore, QMessageBox::Abort );
-            if( result == QMessageBox::Ignore )
+            if( ask_question( "Vertical spacing must be equal to spot size. Ignore and continue?", false ) )
             {
                 ignore_invalid_vertical_spacing = true;
             }
@@ -587,7 +634,7 @@ QSharedPointer<Dataset> DatasetImporter::from_laser_info( const std::filesystem:
 
         if( current.number_of_shots != previous.number_of_shots )
         {
-            QMessageBox::critical( nullptr, "", "Varying number of shots not supported" );
+            show_error( "Varying number of shots not supported" );
             return nullptr;
         }
     }
@@ -844,8 +891,7 @@ QSharedPointer<Dataset> DatasetImporter::from_laser_info( const std::filesystem:
 
     if( baseline_counter )
     {
-        const auto result = QMessageBox::question( nullptr, "", "Subtract average background spectrum for baseline correction?" );
-        if( result == QMessageBox::Yes )
+        if( ask_question( "Subtract average background spectrum for baseline correction?", false ) )
         {
             for( auto& value : baseline )
                 value /= baseline_counter;
@@ -858,8 +904,7 @@ QSharedPointer<Dataset> DatasetImporter::from_laser_info( const std::filesystem:
 
     if( channels_permutation.size() )
     {
-        const auto result = QMessageBox::question( nullptr, "", "Invalid channel order detected. Fix the problem via permutation?" );
-        if( result == QMessageBox::Yes )
+        if( ask_question( "Invalid channel order detected. Fix the problem via permutation?", true ) )
         {
             auto permuted_channels = Array<double>::allocate( channels.size() );
             for( size_t i = 0; i < channels.size(); ++i )
@@ -906,7 +951,7 @@ QSharedPointer<Dataset> DatasetImporter::from_laser_lines( const std::filesystem
         if( !filestream )
         {
             Console::error( "Failed to open laser line file: " + laser_line_filepath.string() );
-            QMessageBox::critical( nullptr, "", "Failed to open laser line file", QMessageBox::Ok );
+            show_error( "Failed to open laser line file" );
             return nullptr;
         }
 
@@ -929,7 +974,7 @@ QSharedPointer<Dataset> DatasetImporter::from_laser_lines( const std::filesystem
         if( direction_of_ablation.find( "Left to Right" ) == std::string::npos )
         {
             Console::error( "Unsupported direction of ablation: " + direction_of_ablation );
-            QMessageBox::critical( nullptr, "", "Unsupported direction of ablation", QMessageBox::Ok );
+            show_error( "Unsupported direction of ablation" );
             return nullptr;
         }
 
@@ -953,7 +998,7 @@ QSharedPointer<Dataset> DatasetImporter::from_laser_lines( const std::filesystem
         if( header.find_first_of( "Cycle time (ms),x[um],y [um]" ) == std::string::npos )
         {
             Console::error( "Invalid header in laser line file: " + laser_line_filepath.string() );
-            QMessageBox::critical( nullptr, "", "Invalid header in laser line file", QMessageBox::Ok );
+            show_error( "Invalid header in laser line file" );
             return nullptr;
         }
 
@@ -980,7 +1025,7 @@ QSharedPointer<Dataset> DatasetImporter::from_laser_lines( const std::filesystem
             if( pixel.intensities.size() != columns.size() )
             {
                 Console::error( "Inconsistent number of columns in laser line file: " + laser_line_filepath.string() );
-                QMessageBox::critical( nullptr, "", "Inconsistent number of columns in laser line file", QMessageBox::Ok );
+                show_error( "Inconsistent number of columns in laser line file" );
                 return nullptr;
             }
 
@@ -992,7 +1037,7 @@ QSharedPointer<Dataset> DatasetImporter::from_laser_lines( const std::filesystem
 
     if( pixels.empty() )
     {
-        QMessageBox::critical( nullptr, "", "Invalid laser line data", QMessageBox::Ok );
+        show_error( "Invalid laser line data" );
         return nullptr;
     }
 
@@ -1034,7 +1079,7 @@ QSharedPointer<Dataset> DatasetImporter::from_rpl( const std::filesystem::path&
     if( !metadata_stream )
     {
         Console::error( "Failed to open metadata file: " + filepath.string() );
-        QMessageBox::critical( nullptr, "", "Failed to open metadata file", QMessageBox::Ok );
+        show_error( "Failed to open metadata file" );
         return nullptr;
     }
 
@@ -1064,14 +1109,14 @@ QSharedPointer<Dataset> DatasetImporter::from_rpl( const std::filesystem::path&
     if( dimensions.x == 0 || dimensions.y == 0 || dimensions.z == 0 )
     {
         Console::error( std::format( "Invalid dimensions: {}x{}x{}", dimensions.x, dimensions.y, dimensions.z ) );
-        QMessageBox::critical( nullptr, "", "Invalid dimensions", QMessageBox::Ok );
+        show_error( "Invalid dimensions" );
         return nullptr;
     }
 
     if( datalength != "1" && byteorder != "little-endian" )
     {
         Console::error( std::format( "Invalid data length or byte order: {}, {}", datalength, byteorder ) );
-        QMessageBox::critical( nullptr, "", "Invalid data length or byte order", QMessageBox::Ok );
+        show_error( "Invalid data length or byte order" );
         return nullptr;
     }
 
@@ -1083,7 +1128,7 @@ QSharedPointer<Dataset> DatasetImporter::from_rpl( const std::filesystem::path&
     if( !intensities_stream )
     {
         Console::error( "Failed to open intensities file: " + intensities_filepath.string() );
-        QMessageBox::critical( nullptr, "", "Failed to open intensities file", QMessageBox::Ok );
+        show_error( "Failed to open intensities file" );
         return nullptr;
     }
 
@@ -1110,7 +1155,7 @@ QSharedPointer<Dataset> DatasetImporter::from_rpl( const std::filesystem::path&
     else
     {
         Console::error( "Invalid data type: " + datatype );
-        QMessageBox::critical( nullptr, "", "Invalid data type", QMessageBox::Ok );
+        show_error( "Invalid data type" );
         return nullptr;
     }
 
@@ -1418,13 +1463,13 @@ QSharedPointer<Dataset> DatasetImporter::from_zarr( const std::filesystem::path&
 
         if( !( hypercube.dtype().kind() == 'f' && hypercube.dtype().itemsize() == sizeof( float ) ) )
         {
-            QMessageBox::critical( nullptr, "", "Unexpected hypercube data type: " + QString::fromStdString( py::str { hypercube.dtype() } ), QMessageBox::Ok );
+            show_error( "Unexpected hypercube data type: " + QString::fromStdString( py::str { hypercube.dtype() } ) );
             return nullptr;
         }
 
         if( !wavenumbers.dtype().is( py::dtype::of<double>() ) )
         {
-            QMessageBox::critical( nullptr, "", "Unexpected wavenumbers data type: " + QString::fromStdString( py::str { wavenumbers.dtype() } ), QMessageBox::Ok );
+            show_error( "Unexpected wavenumbers data type: " + QString::fromStdString( py::str { wavenumbers.dtype() } ) );
             return nullptr;
         }
 
@@ -1451,20 +1496,14 @@ QSharedPointer<Dataset> DatasetImporter::from_zarr( const std::filesystem::path&
     catch( const py::error_already_set& error )
     {
         Console::error( std::format( "Python error during dataset import: {}", error.what() ) );
-        QMessageBox::critical( nullptr, "", "Failed to import dataset", QMessageBox::Ok );
+        show_error( "Failed to import dataset" );
     }
 
     return nullptr;
 }
 
-QSharedPointer<Dataset> DatasetImporter::execute_dialog()
+QSharedPointer<Dataset> DatasetImporter::from_file( const std::filesystem::path& filepath )
 {
-    const auto filepath = std::filesystem::path { QFileDialog::getOpenFileName( nullptr, "Import Dataset...", "", "", nullptr ).toStdWString() };
-    if( filepath.empty() )
-    {
-        return nullptr;
-    }
-
     Console::info( "Importing dataset: " + filepath.string() );
     const auto filename = filepath.filename();
     const auto extension = filepath.extension();
@@ -1498,6 +1537,17 @@ QSharedPointer<Dataset> DatasetImporter::execute_dialog()
         return DatasetImporter::from_rpl( filepath );
     }
 
-    QMessageBox::critical( nullptr, "", "Unsupported file format" );
+    Console::error( "Unsupported file format: " + filepath.string() );
+    show_error( "Unsupported file format" );
     return nullptr;
 }
+QSharedPointer<Dataset> DatasetImporter::execute_dialog()
+{
+    const auto filepath = std::filesystem::path { QFileDialog::getOpenFileName( nullptr, "Import Dataset...", "", "", nullptr ).toStdWString() };
+    if( filepath.empty() )
+    {
+        return nullptr;
+    }
+
+    return DatasetImporter::from_file( filepath );
+}
@@ -7,6 +7,9 @@ class Dataset;
 class DatasetImporter
 {
 public:
+    // Disabled for headless batch rendering, errors are then only logged and questions take their default answer
+    static bool interactive;
+
     static QSharedPointer<Dataset> from_csv( const std::filesystem::path& filepath );
     static QSharedPointer<Dataset> from_data_dims_freq( const std::filesystem::path& filepath );
     static QSharedPointer<Dataset> from_hdf5( const std::filesystem::path& filepath );
@@ -21,6 +24,7 @@ public:
     static QSharedPointer<Dataset> from_xyz( const std::filesystem::path& filepath );
     static QSharedPointer<Dataset> from_zarr( const std::filesystem::path& filepath );
 
+    static QSharedPointer<Dataset> from_file( const std::filesystem::path& filepath );
     static QSharedPointer<Dataset> execute_dialog();
 
 private:
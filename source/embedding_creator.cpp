@@ -4,6 +4,8 @@
 #include "python.hpp"
 #include "segment_selector.hpp"
 
+#include <deque>
+
 #include <qcombobox.h>
 #include <qfiledialog.h>
 #include <qformlayout.h>
@@ -32,7 +34,8 @@ std::filesystem::path EmbeddingCreator::execute()
 
 EmbeddingCreator::EmbeddingCreator() : QDialog {}
 {
-    const auto segmentation = EmbeddingCreator::database_registry->front()->segmentation();
+    const auto primary_database = EmbeddingCreator::database_registry->front().get();
+    const auto segmentation = primary_database->segmentation();
 
     this->setWindowTitle( "Create Embedding..." );
     this->setStyleSheet( "QPushButton { padding: 2px 5px 2px 5px; }" );
@@ -40,6 +43,11 @@ EmbeddingCreator::EmbeddingCreator() : QDialog {}
     // Initialize general properties
     auto segment_selector = new SegmentSelector { segmentation };
 
+    auto restrict_selection = new QComboBox {};
+    restrict_selection->addItem( "No" );
+    restrict_selection->addItem( "Yes" );
+    restrict_selection->setEnabled( !primary_database->selection().empty() );
+
     auto normalization = new QComboBox {};
     normalization->addItem( "Z-score" );
     normalization->addItem( "Min-Max" );
@@ -170,6 +178,7 @@ EmbeddingCreator::EmbeddingCreator() : QDialog {}
 
     auto layout = new QFormLayout { this };
     layout->addRow( "Filter", segment_selector );
+    layout->addRow( "Restrict to Selection", restrict_selection );
 
     struct DatasetWidgets
     {
@@ -312,6 +321,37 @@ EmbeddingCreator::EmbeddingCreator() : QDialog {}
         const auto selected_segment = segment_selector->selected_segment();
         const auto segment_number   = selected_segment ? static_cast<int32_t>( selected_segment->number() ) : -1;
 
+        // Copied, as the element indices can be evicted while the weights dialog is open
+        auto segment_indices = std::vector<uint32_t> {};
+        if( selected_segment )
+        {
+            const auto group = segmentation->element_indices().group( selected_segment->number() );
+            segment_indices.assign( group.begin(), group.end() );
+        }
+
+        auto segment_indices_memoryview = py::object { py::none {} };
+        if( selected_segment )
+        {
+            segment_indices_memoryview = py::memoryview::from_buffer(
+                segment_indices.data(),
+                { segment_indices.size() },
+                { sizeof( uint32_t ) }
+            );
+        }
+
+        // The last image selection further restricts the datapoints
+        const auto selection_indices = restrict_selection->currentText() == "Yes" ? primary_database->selection().indices() : std::vector<uint32_t> {};
+
+        auto selection_indices_memoryview = py::object { py::none {} };
+        if( restrict_selection->currentText() == "Yes" )
+        {
+            selection_indices_memoryview = py::memoryview::from_buffer(
+                selection_indices.data(),
+                { selection_indices.size() },
+                { sizeof( uint32_t ) }
+            );
+        }
+
         // Datasets
         auto datasets_memoryviews           = std::vector<py::object> {};
         auto datasets_channels_indices      = std::vector<std::vector<uint32_t>> {};
@@ -320,6 +360,9 @@ EmbeddingCreator::EmbeddingCreator() : QDialog {}
         auto datasets_features_weights      = std::vector<double> {};
         auto modality_count                 = 0;
 
+        // The views below must outlive the weights dialog, whose event loop runs cache evictions
+        auto values_residencies             = std::deque<CacheResidency> {};
+
         for( size_t database_index = 0; database_index < EmbeddingCreator::database_registry->size(); ++database_index )
         {
             const auto& database    = EmbeddingCreator::database_registry->at( database_index );
@@ -357,11 +400,16 @@ EmbeddingCreator::EmbeddingCreator() : QDialog {}
             {
                 const auto feature_index = features_list->row( item );
                 const auto feature = features->object( feature_index );
-                features_memoryviews.push_back( py::memoryview::from_buffer(
-                    feature->values().data(),
-                    { feature->element_count() },
-                    { sizeof( double ) }
-                ) );
+                values_residencies.emplace_back( &feature->computed_values() );
+                feature->visit_values( [&] ( const auto& values )
+                {
+                    using value_type = typename std::remove_cvref_t<decltype( values )>::value_type;
+                    features_memoryviews.push_back( py::memoryview::from_buffer(
+                        values.data(),
+                        { feature->element_count() },
+                        { sizeof( value_type ) }
+                    ) );
+                } );
             }
 
             if( channels_indices.size() != 0 )
@@ -521,6 +569,8 @@ EmbeddingCreator::EmbeddingCreator() : QDialog {}
         auto locals = py::dict {
             "segmentation"_a = segmentation_memoryview,
             "segment_number"_a = segment_number,
+            "segment_indices"_a = segment_indices_memoryview,
+            "selection_indices"_a = selection_indices_memoryview,
 
             "datasets"_a = datasets_memoryviews,
             "datasets_channels"_a = datasets_channels_indices,
@@ -560,7 +610,9 @@ try:
     segmentation        = np.asarray( segmentation, copy=False )
     print( f"[Embedding] Segmentation: ({segmentation.shape}, {segmentation.dtype}), segment number: {segment_number} " )
 
-    datapoint_indices   = ( np.argwhere( segmentation == segment_number ) if segment_number >= 0 else np.arange( segmentation.shape[0] ) ).astype( np.uint32 ).flatten()
+    datapoint_indices   = ( np.array( segment_indices, dtype=np.uint32 ) if segment_indices is not None else np.arange( segmentation.shape[0], dtype=np.uint32 ) ).flatten()
+    if selection_indices is not None:
+        datapoint_indices = np.intersect1d( datapoint_indices, np.asarray( selection_indices ), assume_unique=True ).astype( np.uint32 )
     datapoint_count     = datapoint_indices.shape[0]    
     print( f"[Embedding] Datapoint indices: ({datapoint_indices.shape}, {datapoint_indices.dtype}) " )
 
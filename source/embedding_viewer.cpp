@@ -264,6 +264,20 @@ void EmbeddingRenderer::update_segmentation( Array<uint32_t> segmentation_number
 
     _context.doneCurrent();
 }
+void EmbeddingRenderer::update_segmentation_numbers( uint32_t offset, std::span<const uint32_t> segmentation_numbers )
+{
+    _context.makeCurrent( &_surface );
+
+    _buffers.segmentation_numbers.bind();
+    const auto byte_offset = static_cast<int>( offset * sizeof( uint32_t ) );
+    const auto byte_count = static_cast<int>( segmentation_numbers.size() * sizeof( uint32_t ) );
+    if( byte_offset + byte_count <= _buffers.segmentation_numbers.size() )
+    {
+        _buffers.segmentation_numbers.write( byte_offset, segmentation_numbers.data(), byte_count );
+    }
+
+    _context.doneCurrent();
+}
 void EmbeddingRenderer::update_point_colors( Array<vec4<float>> point_colors )
 {
     _context.makeCurrent( &_surface );
@@ -400,7 +414,8 @@ EmbeddingViewer::EmbeddingViewer( Database& database ) : _database { database },
 
     const auto segmentation = _database.segmentation();
     QObject::connect( segmentation.get(), &Segmentation::segment_count_changed, this, &EmbeddingViewer::update_coloring );
-    QObject::connect( segmentation.get(), &Segmentation::element_colors_changed, this, &EmbeddingViewer::update_coloring );
+    QObject::connect( segmentation.get(), &Segmentation::segment_color_changed, this, &EmbeddingViewer::update_coloring );
+    QObject::connect( segmentation.get(), &Segmentation::segment_numbers_changed, this, &EmbeddingViewer::update_segmentation_numbers );
 
     const auto colormap_embedding = _database.colormap_embedding();
     QObject::connect( colormap_embedding.get(), &ColormapEmbedding::colors_changed, this, &EmbeddingViewer::update_coloring );
@@ -791,6 +806,38 @@ void EmbeddingViewer::update_coloring()
     _scatterplot_image_valid = false;
     this->update();
 }
+void EmbeddingViewer::update_segmentation_numbers()
+{
+    const auto segmentation = _database.segmentation();
+    if( _coloring != ColoringMode::eSegmentation )
+    {
+        return;
+    }
+    if( segmentation->full_change() )
+    {
+        this->update_coloring();
+        return;
+    }
+
+    const auto& changes = segmentation->changes();
+    if( changes.empty() )
+    {
+        return;
+    }
+
+    // Edits are mostly local, so only the range of element indices spanned by the changes is uploaded
+    auto [minimum, maximum] = std::minmax_element( changes.begin(), changes.end(), [] ( const auto& a, const auto& b )
+    {
+        return a.element_index < b.element_index;
+    } );
+    const auto begin = minimum->element_index;
+    const auto end = maximum->element_index + 1;
+
+    _renderer->update_segmentation_numbers( begin, std::span { segmentation->segment_numbers().data() + begin, end - begin } );
+
+    _scatterplot_image_valid = false;
+    this->update();
+}
 void EmbeddingViewer::reset_projection_matrix()
 {
     _projection_matrix = QMatrix4x4 {};
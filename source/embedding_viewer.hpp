@@ -2,6 +2,8 @@
 #include "database.hpp"
 #include "utility.hpp"
 
+#include <span>
+
 #include <qoffscreensurface.h>
 #include <qopenglbuffer.h>
 #include <qopenglcontext.h>
@@ -28,6 +30,7 @@ public:
 
     void update_points( const std::vector<vec2<float>>& point_positions, const std::vector<uint32_t>& point_indices );
     void update_segmentation( Array<uint32_t> segmentation_numbers, Array<vec4<float>> segment_colors );
+    void update_segmentation_numbers( uint32_t offset, std::span<const uint32_t> segmentation_numbers );
     void update_point_colors( Array<vec4<float>> point_colors );
 
     QImage render( const QMatrix4x4& projection_matrix, GLfloat point_size, bool use_point_colors );
@@ -136,6 +139,7 @@ signals:
 
 private:
     void update_coloring();
+    void update_segmentation_numbers();
     void reset_projection_matrix();
     void import_embedding( const std::filesystem::path& filepath );
     void create_screenshot( uint32_t scaling ) const;
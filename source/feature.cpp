@@ -1,7 +1,11 @@
 #include "feature.hpp"
 
+#include "configuration.hpp"
 #include "dataset.hpp"
 
+#include <atomic>
+#include <thread>
+
 // ----- Feature ----- //
 
 Feature::Feature()
@@ -12,11 +16,16 @@ Feature::Feature()
     , _moments { std::bind( &Feature::compute_moments, this ) }
     , _quantiles { std::bind( &Feature::compute_quantiles, this ) }
     , _sorted_indices { std::bind( &Feature::compute_sorted_indices, this ) }
+    , _sketch { std::bind( &Feature::compute_sketch, this ) }
 {
+    QObject::connect( this, &Feature::precision_changed, &_values, &ComputedObject::invalidate );
+
     QObject::connect( &_values, &ComputedObject::changed, &_extremes, &ComputedObject::invalidate );
     QObject::connect( &_values, &ComputedObject::changed, &_moments, &ComputedObject::invalidate );
     QObject::connect( &_values, &ComputedObject::changed, &_quantiles, &ComputedObject::invalidate );
     QObject::connect( &_values, &ComputedObject::changed, &_sorted_indices, &ComputedObject::invalidate );
+    QObject::connect( &_values, &ComputedObject::changed, &_sketch, &ComputedObject::invalidate );
+    QObject::connect( this, &Feature::approximate_statistics_changed, &_quantiles, &ComputedObject::invalidate );
 
     QObject::connect( &_identifier, &Override<QString>::value_changed, this, [this] { emit identifier_changed( _identifier.value() ); } );
     QObject::connect( &_values, &ComputedObject::changed, this, &Feature::values_changed );
@@ -24,6 +33,7 @@ Feature::Feature()
     QObject::connect( &_moments, &ComputedObject::changed, this, &Feature::moments_changed );
     QObject::connect( &_quantiles, &ComputedObject::changed, this, &Feature::quantiles_changed );
     QObject::connect( &_sorted_indices, &ComputedObject::changed, this, &Feature::sorted_indices_changed );
+    QObject::connect( &_sketch, &ComputedObject::changed, this, &Feature::sketch_changed );
 }
 
 const QString& Feature::identifier() const noexcept
@@ -39,10 +49,73 @@ Override<QString>& Feature::override_identifier() noexcept
     return _identifier;
 }
 
-const Array<double>& Feature::values() const noexcept
+Feature::Precision Feature::precision() const noexcept
+{
+    return _precision;
+}
+void Feature::update_precision( Precision precision )
+{
+    if( _precision != precision )
+    {
+        _precision = precision;
+        emit precision_changed( _precision );
+    }
+}
+
+bool Feature::approximate_statistics() const noexcept
+{
+    return _approximate_statistics;
+}
+void Feature::update_approximate_statistics( bool approximate_statistics )
+{
+    if( _approximate_statistics != approximate_statistics )
+    {
+        _approximate_statistics = approximate_statistics;
+        emit approximate_statistics_changed( _approximate_statistics );
+    }
+}
+
+bool Feature::depends_on( const Feature* feature ) const
+{
+    if( this == feature )
+    {
+        return true;
+    }
+    for( const auto& source_feature : this->source_features() )
+    {
+        if( source_feature && source_feature->depends_on( feature ) )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+const Feature::Values& Feature::values() const noexcept
 {
     return *_values;
 }
+const ComputedObject& Feature::computed_values() const noexcept
+{
+    return _values;
+}
+bool Feature::values_present() const noexcept
+{
+    return _values.present();
+}
+Feature::Values Feature::sampled_values( std::span<const uint32_t> element_indices ) const
+{
+    // Present values are gathered, otherwise only the sampled elements are computed where the feature supports it
+    return _values.present() ? Feature::compute_sampled_values( element_indices ) : this->compute_sampled_values( element_indices );
+}
+double Feature::value( uint32_t element_index ) const
+{
+    return std::visit( [element_index] ( const auto& values )
+    {
+        return static_cast<double>( values[element_index] );
+    }, this->values() );
+}
+
 const Feature::Extremes& Feature::extremes() const noexcept
 {
     return *_extremes;
@@ -59,6 +132,41 @@ const Array<uint32_t>& Feature::sorted_indices() const noexcept
 {
     return *_sorted_indices;
 }
+const QuantileSketch& Feature::sketch() const noexcept
+{
+    return *_sketch;
+}
+
+std::vector<QSharedPointer<const Feature>> Feature::source_features() const
+{
+    return {};
+}
+Feature::Values Feature::allocate_values() const
+{
+    return this->allocate_values( this->element_count() );
+}
+Feature::Values Feature::allocate_values( uint32_t value_count ) const
+{
+    if( _precision == Precision::eSingle )
+    {
+        return Array<float> { value_count, 0.0f };
+    }
+    return Array<double> { value_count, 0.0 };
+}
+
+Feature::Values Feature::compute_sampled_values( std::span<const uint32_t> element_indices ) const
+{
+    auto sampled_values = this->allocate_values( static_cast<uint32_t>( element_indices.size() ) );
+    std::visit( [&] ( auto& sampled_values, const auto& values )
+    {
+        using value_type = typename std::remove_cvref_t<decltype( sampled_values )>::value_type;
+        utility::iterate_parallel( static_cast<uint32_t>( element_indices.size() ), [&] ( uint32_t value_index )
+        {
+            sampled_values[value_index] = static_cast<value_type>( values[element_indices[value_index]] );
+        } );
+    }, sampled_values, this->values() );
+    return sampled_values;
+}
 
 Feature::Extremes Feature::compute_extremes() const
 {
@@ -73,11 +181,14 @@ Feature::Extremes Feature::compute_extremes() const
         extremes.minimum = std::numeric_limits<double>::max();
         extremes.maximum = std::numeric_limits<double>::lowest();
 
-        for( const auto value : this->values() )
+        this->visit_values( [&extremes] ( const auto& values )
         {
-            extremes.minimum = std::min( extremes.minimum, static_cast<double>( value ) );
-            extremes.maximum = std::max( extremes.maximum, static_cast<double>( value ) );
-        }
+            for( const auto value : values )
+            {
+                extremes.minimum = std::min( extremes.minimum, static_cast<double>( value ) );
+                extremes.maximum = std::max( extremes.maximum, static_cast<double>( value ) );
+            }
+        } );
     }
 
     return extremes;
@@ -93,15 +204,18 @@ Feature::Moments Feature::compute_moments() const
     if( this->element_count() > 0 )
     {
         auto counter = uint32_t { 0 };
-        for( const auto value : this->values() )
+        this->visit_values( [&moments, &counter] ( const auto& values )
         {
-            ++counter;
-            const auto delta = value - moments.average;
-            moments.average += delta / counter;
+            for( const auto value : values )
+            {
+                ++counter;
+                const auto delta = static_cast<double>( value ) - moments.average;
+                moments.average += delta / counter;
 
-            const auto delta2 = value - moments.average;
-            moments.standard_deviation += delta * delta2;
-        }
+                const auto delta2 = static_cast<double>( value ) - moments.average;
+                moments.standard_deviation += delta * delta2;
+            }
+        } );
         moments.standard_deviation = std::sqrt( moments.standard_deviation / counter );
     }
 
@@ -113,36 +227,48 @@ Feature::Quantiles Feature::compute_quantiles() const
     auto quantiles = Feature::Quantiles {
         .lower_quartile = 0.0,
         .median = 0.0,
-        .upper_quartile = 0.0
+        .upper_quartile = 0.0,
+        .rank_error = 0.0
     };
 
+    if( _approximate_statistics && this->element_count() > 0 )
+    {
+        const auto& sketch = this->sketch();
+        quantiles.lower_quartile = sketch.quantile( 0.25 );
+        quantiles.median = sketch.quantile( 0.5 );
+        quantiles.upper_quartile = sketch.quantile( 0.75 );
+        quantiles.rank_error = sketch.rank_error();
+        return quantiles;
+    }
+
     if( this->element_count() > 0 )
     {
-        const auto& values = this->values();
         const auto& sorted_indices = this->sorted_indices();
-
-        const auto compute_quantile = [&values, &sorted_indices] ( double quantile ) -> double
+        this->visit_values( [&quantiles, &sorted_indices] ( const auto& values )
         {
-            const auto position = ( values.size() - 1 ) * quantile;
-            const auto lower_index = static_cast<uint32_t>( std::floor( position ) );
-            const auto upper_index = static_cast<uint32_t>( std::ceil( position ) );
-            const auto fraction = position - lower_index;
-
-            if( lower_index == upper_index )
+            const auto compute_quantile = [&values, &sorted_indices] ( double quantile ) -> double
             {
-                return values[sorted_indices[lower_index]];
-            }
-            else
-            {
-                const auto lower_value = values[sorted_indices[lower_index]];
-                const auto upper_value = values[sorted_indices[upper_index]];
-                return lower_value + fraction * ( upper_value - lower_value );
-            }
-        };
+                const auto position = ( values.size() - 1 ) * quantile;
+                const auto lower_index = static_cast<uint32_t>( std::floor( position ) );
+                const auto upper_index = static_cast<uint32_t>( std::ceil( position ) );
+                const auto fraction = position - lower_index;
+
+                if( lower_index == upper_index )
+                {
+                    return static_cast<double>( values[sorted_indices[lower_index]] );
+                }
+                else
+                {
+                    const auto lower_value = static_cast<double>( values[sorted_indices[lower_index]] );
+                    const auto upper_value = static_cast<double>( values[sorted_indices[upper_index]] );
+                    return lower_value + fraction * ( upper_value - lower_value );
+                }
+            };
 
-        quantiles.lower_quartile = compute_quantile( 0.25 );
-        quantiles.median = compute_quantile( 0.5 );
-        quantiles.upper_quartile = compute_quantile( 0.75 );
+            quantiles.lower_quartile = compute_quantile( 0.25 );
+            quantiles.median = compute_quantile( 0.5 );
+            quantiles.upper_quartile = compute_quantile( 0.75 );
+        } );
     }
 
     return quantiles;
@@ -153,20 +279,62 @@ Array<uint32_t> Feature::compute_sorted_indices() const
     auto sorted_indices = Array<uint32_t>::allocate( this->element_count() );
     std::iota( sorted_indices.begin(), sorted_indices.end(), 0 );
 
-    const auto& values = this->values();
-    std::sort( std::execution::par, sorted_indices.begin(), sorted_indices.end(), [&] ( uint32_t a, uint32_t b )
+    this->visit_values( [&sorted_indices] ( const auto& values )
     {
-        return values[a] < values[b];
+        std::sort( std::execution::par, sorted_indices.begin(), sorted_indices.end(), [&] ( uint32_t a, uint32_t b )
+        {
+            return values[a] < values[b];
+        } );
     } );
 
     return sorted_indices;
 }
+QuantileSketch Feature::compute_sketch() const
+{
+    Console::info( "Feature::compute_sketch" );
+    auto sketch = QuantileSketch { config::quantile_sketch_k };
+
+    const auto element_count = this->element_count();
+    if( element_count == 0 )
+    {
+        return sketch;
+    }
+
+    // Chunks are sketched independently and merged afterwards, which keeps the rank error bound of a single sketch
+    const auto chunk_count = std::clamp( element_count / ( uint32_t { 1 } << 16 ), 1u, std::max( std::thread::hardware_concurrency(), 1u ) );
+    const auto chunk_size = ( element_count + chunk_count - 1 ) / chunk_count;
+    auto chunk_sketches = std::vector<QuantileSketch>( chunk_count, sketch );
+
+    this->visit_values( [&] ( const auto& values )
+    {
+        utility::iterate_parallel( chunk_count, [&] ( uint32_t chunk_index )
+        {
+            const auto begin = std::min( chunk_index * chunk_size, element_count );
+            const auto end = std::min( begin + chunk_size, element_count );
+            for( uint32_t element_index = begin; element_index < end; ++element_index )
+            {
+                chunk_sketches[chunk_index].insert( static_cast<double>( values[element_index] ) );
+            }
+        } );
+    } );
+
+    for( const auto& chunk_sketch : chunk_sketches )
+    {
+        sketch.merge( chunk_sketch );
+    }
+
+    return sketch;
+}
 
 // ----- ElementFilterFeature ----- //
 
 ElementFilterFeature::ElementFilterFeature( QSharedPointer<const Feature> feature, std::vector<uint32_t> element_indices )
     : Feature {}, _feature { feature }, _element_indices { std::move( element_indices ) }
 {
+    if( feature )
+    {
+        _precision = feature->precision();
+    }
 }
 
 uint32_t ElementFilterFeature::element_count() const noexcept
@@ -174,18 +342,49 @@ uint32_t ElementFilterFeature::element_count() const noexcept
     return static_cast<uint32_t>( _element_indices.size() );
 }
 
-Array<double> ElementFilterFeature::compute_values() const
+std::vector<QSharedPointer<const Feature>> ElementFilterFeature::source_features() const
+{
+    return { _feature.lock() };
+}
+Feature::Values ElementFilterFeature::compute_values() const
 {
     Console::info( "ElementFilterFeature::compute_values" );
-    auto values = Array<double> { this->element_count(), 0.0 };
+    auto values = this->allocate_values();
 
-    if( const auto feature = _feature.lock(); feature && feature->element_count() > _element_indices.back() )
+    if( const auto feature = _feature.lock(); feature && !_element_indices.empty() && feature->element_count() > _element_indices.back() )
     {
-        const auto& feature_values = feature->values();
-        utility::iterate_parallel( this->element_count(), [&] ( uint32_t element_index )
+        std::visit( [&] ( auto& values, const auto& feature_values )
         {
-            values[element_index] = feature_values[_element_indices[element_index]];
-        } );
+            using value_type = typename std::remove_cvref_t<decltype( values )>::value_type;
+            utility::iterate_parallel( this->element_count(), [&] ( uint32_t element_index )
+            {
+                values[element_index] = static_cast<value_type>( feature_values[_element_indices[element_index]] );
+            } );
+        }, values, feature->values() );
+    }
+
+    return values;
+}
+Feature::Values ElementFilterFeature::compute_sampled_values( std::span<const uint32_t> element_indices ) const
+{
+    auto values = this->allocate_values( static_cast<uint32_t>( element_indices.size() ) );
+
+    if( const auto feature = _feature.lock(); feature && !_element_indices.empty() && feature->element_count() > _element_indices.back() )
+    {
+        auto feature_element_indices = std::vector<uint32_t>( element_indices.size() );
+        for( size_t i = 0; i < element_indices.size(); ++i )
+        {
+            feature_element_indices[i] = _element_indices[element_indices[i]];
+        }
+
+        std::visit( [&] ( auto& values, const auto& feature_values )
+        {
+            using value_type = typename std::remove_cvref_t<decltype( values )>::value_type;
+            utility::iterate_parallel( static_cast<uint32_t>( element_indices.size() ), [&] ( uint32_t value_index )
+            {
+                values[value_index] = static_cast<value_type>( feature_values[value_index] );
+            } );
+        }, values, feature->sampled_values( feature_element_indices ) );
     }
 
     return values;
@@ -276,147 +475,169 @@ void DatasetChannelsFeature::update_identifier()
         _identifier.update_automatic_value( "DatasetChannelsFeature" );
     }
 }
-Array<double> DatasetChannelsFeature::compute_values() const
+Feature::Values DatasetChannelsFeature::compute_values() const
 {
     Console::info( "DatasetChannelsFeature::compute_values" );
-    auto values = Array<double> { this->element_count(), 0.0 };
+    return this->gather_values( {} );
+}
+Feature::Values DatasetChannelsFeature::compute_sampled_values( std::span<const uint32_t> element_indices ) const
+{
+    return element_indices.empty() ? this->allocate_values( 0 ) : this->gather_values( element_indices );
+}
+Feature::Values DatasetChannelsFeature::gather_values( std::span<const uint32_t> element_indices ) const
+{
+    auto values = element_indices.empty() ? this->allocate_values() : this->allocate_values( static_cast<uint32_t>( element_indices.size() ) );
 
     if( const auto dataset = _dataset.lock() )
     {
-        dataset->visit( [&] ( const auto& dataset )
+        std::visit( [&] ( auto& values )
         {
-            const auto& intensities = dataset.intensities();
-            const auto& channel_positions = dataset.channel_positions();
+            using value_type = typename std::remove_cvref_t<decltype( values )>::value_type;
 
-            const auto gather_value = [&] ( uint32_t element_index, uint32_t channel_index )
+            dataset->visit( [&] ( const auto& dataset )
             {
-                return static_cast<double>( intensities.value( { element_index, channel_index } ) );
-            };
+                const auto& intensities = dataset.intensities();
+                const auto& channel_positions = dataset.channel_positions();
 
-            if( _reduction == Reduction::eAccumulate )
-            {
-                if( _baseline_correction == BaselineCorrection::eNone )
+                // Value indices map to elements directly, or through the sampled element indices
+                const auto value_count = element_indices.empty() ? dataset.element_count() : static_cast<uint32_t>( element_indices.size() );
+                const auto gather_value = [&] ( uint32_t value_index, uint32_t channel_index )
+                {
+                    const auto element_index = element_indices.empty() ? value_index : element_indices[value_index];
+                    return static_cast<double>( intensities.value( { element_index, channel_index } ) );
+                };
+
+                if( _reduction == Reduction::eAccumulate )
                 {
-                    utility::iterate_parallel<uint32_t>( 0, dataset.element_count(), [&] ( uint32_t element_index )
+                    if( _baseline_correction == BaselineCorrection::eNone )
                     {
-                        auto& value = values[element_index] = 0.0;
-                        for( uint32_t channel_index = _channel_range.lower; channel_index <= _channel_range.upper; ++channel_index )
+                        utility::iterate_parallel<uint32_t>( 0, value_count, [&] ( uint32_t value_index )
                         {
-                            value += gather_value( element_index, channel_index );
-                        }
-                    } );
-                }
-                else if( _baseline_correction == BaselineCorrection::eMinimum )
-                {
-                    utility::iterate_parallel<uint32_t>( 0, dataset.element_count(), [&] ( uint32_t element_index )
+                            auto value = 0.0;
+                            for( uint32_t channel_index = _channel_range.lower; channel_index <= _channel_range.upper; ++channel_index )
+                            {
+                                value += gather_value( value_index, channel_index );
+                            }
+                            values[value_index] = static_cast<value_type>( value );
+                        } );
+                    }
+                    else if( _baseline_correction == BaselineCorrection::eMinimum )
                     {
-                        auto& value = values[element_index] = 0.0;
-                        auto minimum_intensity = std::numeric_limits<double>::max();
-
-                        for( uint32_t channel_index = _channel_range.lower; channel_index <= _channel_range.upper; ++channel_index )
+                        utility::iterate_parallel<uint32_t>( 0, value_count, [&] ( uint32_t value_index )
                         {
-                            const auto intensity = gather_value( element_index, channel_index );
-                            value += intensity;
-                            minimum_intensity = std::min( minimum_intensity, intensity );
-                        }
-
-                        value -= minimum_intensity * ( _channel_range.upper - _channel_range.lower + 1 );
-                    } );
-                }
-                else if( _baseline_correction == BaselineCorrection::eLinear )
-                {
-                    utility::iterate_parallel<uint32_t>( 0, dataset.element_count(), [&] ( uint32_t element_index )
+                            auto value = 0.0;
+                            auto minimum_intensity = std::numeric_limits<double>::max();
+
+                            for( uint32_t channel_index = _channel_range.lower; channel_index <= _channel_range.upper; ++channel_index )
+                            {
+                                const auto intensity = gather_value( value_index, channel_index );
+                                value += intensity;
+                                minimum_intensity = std::min( minimum_intensity, intensity );
+                            }
+
+                            value -= minimum_intensity * ( _channel_range.upper - _channel_range.lower + 1 );
+                            values[value_index] = static_cast<value_type>( value );
+                        } );
+                    }
+                    else if( _baseline_correction == BaselineCorrection::eLinear )
                     {
-                        auto& value = values[element_index] = 0.0;
-
-                        const auto first_channel = channel_positions[_channel_range.lower];
-                        const auto first_intensity = gather_value( element_index, _channel_range.lower );
-
-                        const auto last_channel = channel_positions[_channel_range.upper];
-                        const auto last_intensity = gather_value( element_index, _channel_range.upper );
-
-                        for( uint32_t channel_index = _channel_range.lower; channel_index <= _channel_range.upper; ++channel_index )
+                        utility::iterate_parallel<uint32_t>( 0, value_count, [&] ( uint32_t value_index )
                         {
-                            const auto intensity = gather_value( element_index, channel_index );
-                            const auto t = ( channel_positions[channel_index] - first_channel ) / ( last_channel - first_channel );
-                            const auto intensity_correction = first_intensity + t * ( last_intensity - first_intensity );
-                            value += intensity - intensity_correction;
-                        }
-                    } );
+                            auto value = 0.0;
+
+                            const auto first_channel = channel_positions[_channel_range.lower];
+                            const auto first_intensity = gather_value( value_index, _channel_range.lower );
+
+                            const auto last_channel = channel_positions[_channel_range.upper];
+                            const auto last_intensity = gather_value( value_index, _channel_range.upper );
+
+                            for( uint32_t channel_index = _channel_range.lower; channel_index <= _channel_range.upper; ++channel_index )
+                            {
+                                const auto intensity = gather_value( value_index, channel_index );
+                                const auto t = ( channel_positions[channel_index] - first_channel ) / ( last_channel - first_channel );
+                                const auto intensity_correction = first_intensity + t * ( last_intensity - first_intensity );
+                                value += intensity - intensity_correction;
+                            }
+                            values[value_index] = static_cast<value_type>( value );
+                        } );
+                    }
                 }
-            }
-            else if( _reduction == Reduction::eIntegrate )
-            {
-                if( _baseline_correction == BaselineCorrection::eNone )
+                else if( _reduction == Reduction::eIntegrate )
                 {
-                    utility::iterate_parallel<uint32_t>( 0, dataset.element_count(), [&] ( uint32_t element_index )
+                    if( _baseline_correction == BaselineCorrection::eNone )
                     {
-                        auto& value = values[element_index] = 0.0;
-
-                        auto previous_channel = channel_positions[_channel_range.lower];
-                        auto previous_intensity = gather_value( element_index, _channel_range.lower );
-
-                        for( uint32_t channel_index = _channel_range.lower + 1; channel_index <= _channel_range.upper; ++channel_index )
+                        utility::iterate_parallel<uint32_t>( 0, value_count, [&] ( uint32_t value_index )
                         {
-                            const auto channel = channel_positions[channel_index];
-                            const auto intensity = gather_value( element_index, channel_index );
-                            value += ( channel - previous_channel ) * ( previous_intensity + intensity ) / 2.0;
-                            previous_channel = channel;
-                            previous_intensity = intensity;
-                        }
-                    } );
-                }
-                else if( _baseline_correction == BaselineCorrection::eMinimum )
-                {
-                    utility::iterate_parallel<uint32_t>( 0, dataset.element_count(), [&] ( uint32_t element_index )
+                            auto value = 0.0;
+
+                            auto previous_channel = channel_positions[_channel_range.lower];
+                            auto previous_intensity = gather_value( value_index, _channel_range.lower );
+
+                            for( uint32_t channel_index = _channel_range.lower + 1; channel_index <= _channel_range.upper; ++channel_index )
+                            {
+                                const auto channel = channel_positions[channel_index];
+                                const auto intensity = gather_value( value_index, channel_index );
+                                value += ( channel - previous_channel ) * ( previous_intensity + intensity ) / 2.0;
+                                previous_channel = channel;
+                                previous_intensity = intensity;
+                            }
+                            values[value_index] = static_cast<value_type>( value );
+                        } );
+                    }
+                    else if( _baseline_correction == BaselineCorrection::eMinimum )
                     {
-                        auto& value = values[element_index] = 0.0;
-
-                        auto previous_channel = channel_positions[_channel_range.lower];
-                        auto previous_intensity = gather_value( element_index, _channel_range.lower );
-
-                        auto minimum_intensity = previous_intensity;
-
-                        for( uint32_t channel_index = _channel_range.lower + 1; channel_index <= _channel_range.upper; ++channel_index )
+                        utility::iterate_parallel<uint32_t>( 0, value_count, [&] ( uint32_t value_index )
                         {
-                            const auto channel = channel_positions[channel_index];
-                            const auto intensity = gather_value( element_index, channel_index );
-                            value += ( channel - previous_channel ) * ( previous_intensity + intensity ) / 2.0;
-                            previous_channel = channel;
-                            previous_intensity = intensity;
+                            auto value = 0.0;
 
-                            minimum_intensity = std::min( minimum_intensity, intensity );
-                        }
+                            auto previous_channel = channel_positions[_channel_range.lower];
+                            auto previous_intensity = gather_value( value_index, _channel_range.lower );
 
-                        value -= minimum_intensity * ( channel_positions[_channel_range.upper] - channel_positions[_channel_range.lower] );
-                    } );
-                }
-                else if( _baseline_correction == BaselineCorrection::eLinear )
-                {
-                    utility::iterate_parallel<uint32_t>( 0, dataset.element_count(), [&] ( uint32_t element_index )
-                    {
-                        auto& value = values[element_index] = 0.0;
+                            auto minimum_intensity = previous_intensity;
 
-                        auto previous_channel = channel_positions[_channel_range.lower];
-                        auto previous_intensity = gather_value( element_index, _channel_range.lower );
+                            for( uint32_t channel_index = _channel_range.lower + 1; channel_index <= _channel_range.upper; ++channel_index )
+                            {
+                                const auto channel = channel_positions[channel_index];
+                                const auto intensity = gather_value( value_index, channel_index );
+                                value += ( channel - previous_channel ) * ( previous_intensity + intensity ) / 2.0;
+                                previous_channel = channel;
+                                previous_intensity = intensity;
 
-                        const auto first_channel = previous_channel;
-                        const auto first_intensity = previous_intensity;
+                                minimum_intensity = std::min( minimum_intensity, intensity );
+                            }
 
-                        for( uint32_t channel_index = _channel_range.lower + 1; channel_index <= _channel_range.upper; ++channel_index )
+                            value -= minimum_intensity * ( channel_positions[_channel_range.upper] - channel_positions[_channel_range.lower] );
+                            values[value_index] = static_cast<value_type>( value );
+                        } );
+                    }
+                    else if( _baseline_correction == BaselineCorrection::eLinear )
+                    {
+                        utility::iterate_parallel<uint32_t>( 0, value_count, [&] ( uint32_t value_index )
                         {
-                            const auto channel = channel_positions[channel_index];
-                            const auto intensity = gather_value( element_index, channel_index );
-                            value += ( channel - previous_channel ) * ( previous_intensity + intensity ) / 2.0;
-                            previous_channel = channel;
-                            previous_intensity = intensity;
-                        }
-
-                        value -= ( previous_channel - first_channel ) * ( previous_intensity + first_intensity ) / 2.0;
-                    } );
+                            auto value = 0.0;
+
+                            auto previous_channel = channel_positions[_channel_range.lower];
+                            auto previous_intensity = gather_value( value_index, _channel_range.lower );
+
+                            const auto first_channel = previous_channel;
+                            const auto first_intensity = previous_intensity;
+
+                            for( uint32_t channel_index = _channel_range.lower + 1; channel_index <= _channel_range.upper; ++channel_index )
+                            {
+                                const auto channel = channel_positions[channel_index];
+                                const auto intensity = gather_value( value_index, channel_index );
+                                value += ( channel - previous_channel ) * ( previous_intensity + intensity ) / 2.0;
+                                previous_channel = channel;
+                                previous_intensity = intensity;
+                            }
+
+                            value -= ( previous_channel - first_channel ) * ( previous_intensity + first_intensity ) / 2.0;
+                            values[value_index] = static_cast<value_type>( value );
+                        } );
+                    }
                 }
-            }
-        } );
+            } );
+        }, values );
     }
 
     return values;
@@ -453,6 +674,11 @@ QSharedPointer<const Feature> CombinationFeature::first_feature() const
 }
 void CombinationFeature::update_first_feature( QSharedPointer<const Feature> feature )
 {
+    if( feature && feature->depends_on( this ) )
+    {
+        Console::warning( "CombinationFeature::update_first_feature: Feature would depend on itself" );
+        return;
+    }
     if( _first_feature != feature )
     {
         if( auto feature = _first_feature.lock() )
@@ -476,6 +702,11 @@ QSharedPointer<const Feature> CombinationFeature::second_feature() const
 }
 void CombinationFeature::update_second_feature( QSharedPointer<const Feature> feature )
 {
+    if( feature && feature->depends_on( this ) )
+    {
+        Console::warning( "CombinationFeature::update_second_feature: Feature would depend on itself" );
+        return;
+    }
     if( _second_feature != feature )
     {
         if( auto feature = _second_feature.lock() )
@@ -525,50 +756,70 @@ void CombinationFeature::update_identifier()
 
     _identifier.update_automatic_value( identifier );
 }
-Array<double> CombinationFeature::compute_values() const
+std::vector<QSharedPointer<const Feature>> CombinationFeature::source_features() const
+{
+    return { _first_feature.lock(), _second_feature.lock() };
+}
+Feature::Values CombinationFeature::compute_values() const
 {
     Console::info( "CombinationFeature::compute_values" );
-    auto values = Array<double> { this->element_count(), 0.0 };
 
     const auto first = _first_feature.lock();
     const auto second = _second_feature.lock();
-
-    if( first && second )
+    if( !first || !second )
+    {
+        return this->allocate_values();
+    }
+    return this->combine_values( first->values(), second->values(), this->element_count() );
+}
+Feature::Values CombinationFeature::compute_sampled_values( std::span<const uint32_t> element_indices ) const
+{
+    const auto first = _first_feature.lock();
+    const auto second = _second_feature.lock();
+    if( !first || !second )
+    {
+        return this->allocate_values( static_cast<uint32_t>( element_indices.size() ) );
+    }
+    return this->combine_values( first->sampled_values( element_indices ), second->sampled_values( element_indices ), static_cast<uint32_t>( element_indices.size() ) );
+}
+Feature::Values CombinationFeature::combine_values( const Values& first_feature_values, const Values& second_feature_values, uint32_t value_count ) const
+{
+    auto values = this->allocate_values( value_count );
+    std::visit( [&] ( auto& values, const auto& first_values, const auto& second_values )
     {
-        const auto& first_values = first->values();
-        const auto& second_values = second->values();
+        using value_type = typename std::remove_cvref_t<decltype( values )>::value_type;
 
         if( _operation == Operation::eAddition )
         {
-            utility::iterate_parallel( this->element_count(), [&] ( uint32_t element_index )
+            utility::iterate_parallel( value_count, [&] ( uint32_t element_index )
             {
-                values[element_index] = first_values[element_index] + second_values[element_index];
+                values[element_index] = static_cast<value_type>( static_cast<double>( first_values[element_index] ) + second_values[element_index] );
             } );
         }
         else if( _operation == Operation::eSubtraction )
         {
-            utility::iterate_parallel( this->element_count(), [&] ( uint32_t element_index )
+            utility::iterate_parallel( value_count, [&] ( uint32_t element_index )
             {
-                values[element_index] = first_values[element_index] - second_values[element_index];
+                values[element_index] = static_cast<value_type>( static_cast<double>( first_values[element_index] ) - second_values[element_index] );
             } );
         }
         else if( _operation == Operation::eMultiplication )
         {
-            utility::iterate_parallel( this->element_count(), [&] ( uint32_t element_index )
+            utility::iterate_parallel( value_count, [&] ( uint32_t element_index )
             {
-                values[element_index] = first_values[element_index] * second_values[element_index];
+                values[element_index] = static_cast<value_type>( static_cast<double>( first_values[element_index] ) * second_values[element_index] );
             } );
         }
         else if( _operation == Operation::eDivision )
         {
-            auto contains_nan = false;
+            auto contains_nan = std::atomic<bool> { false };
 
-            utility::iterate_parallel( this->element_count(), [&] ( uint32_t element_index )
+            utility::iterate_parallel( value_count, [&] ( uint32_t element_index )
             {
-                values[element_index] = first_values[element_index] / second_values[element_index];
+                values[element_index] = static_cast<value_type>( static_cast<double>( first_values[element_index] ) / second_values[element_index] );
                 if( std::isnan( values[element_index] ) )
                 {
-                    contains_nan = true;
+                    contains_nan.store( true, std::memory_order_relaxed );
                 }
             } );
 
@@ -581,7 +832,434 @@ Array<double> CombinationFeature::compute_values() const
         {
             Console::error( "CombinationFeature::compute_values: Unsupported operation" );
         }
+    }, values, first_feature_values, second_feature_values );
+
+    return values;
+}
+
+// ----- SpatialFilterFeature ----- //
+
+namespace
+{
+    // Rows are processed in blocks so that vertical passes can keep a running accumulator per block
+    constexpr auto spatial_filter_block_size = uint32_t { 64 };
+
+    // All passes replicate the border pixels and keep their inner loops contiguous over x for vectorization
+    void box_filter_rows( const double* source, double* target, uint32_t width, uint32_t height, uint32_t radius )
+    {
+        const auto normalization = 1.0 / ( 2 * radius + 1 );
+        utility::iterate_parallel( height, [=] ( uint32_t y )
+        {
+            const auto row_source = source + size_t { y } * width;
+            const auto row_target = target + size_t { y } * width;
+            const auto sample = [=] ( int64_t x )
+            {
+                return row_source[std::clamp<int64_t>( x, 0, width - 1 )];
+            };
+
+            auto sum = 0.0;
+            for( int64_t x = -static_cast<int64_t>( radius ); x <= radius; ++x )
+            {
+                sum += sample( x );
+            }
+            for( int64_t x = 0; x < width; ++x )
+            {
+                row_target[x] = sum * normalization;
+                sum += sample( x + radius + 1 ) - sample( x - radius );
+            }
+        } );
+    }
+    void box_filter_columns( const double* source, double* target, uint32_t width, uint32_t height, uint32_t radius )
+    {
+        const auto normalization = 1.0 / ( 2 * radius + 1 );
+        const auto block_count = ( height + spatial_filter_block_size - 1 ) / spatial_filter_block_size;
+        utility::iterate_parallel( block_count, [=] ( uint32_t block_index )
+        {
+            const auto row = [=] ( int64_t y )
+            {
+                return source + static_cast<size_t>( std::clamp<int64_t>( y, 0, height - 1 ) ) * width;
+            };
+
+            const auto first = static_cast<int64_t>( block_index ) * spatial_filter_block_size;
+            const auto last = std::min<int64_t>( first + spatial_filter_block_size, height );
+
+            auto sums = std::vector<double>( width, 0.0 );
+            for( auto y = first - radius; y <= first + radius; ++y )
+            {
+                const auto row_source = row( y );
+                for( uint32_t x = 0; x < width; ++x )
+                {
+                    sums[x] += row_source[x];
+                }
+            }
+
+            for( auto y = first; y < last; ++y )
+            {
+                const auto row_target = target + static_cast<size_t>( y ) * width;
+                for( uint32_t x = 0; x < width; ++x )
+                {
+                    row_target[x] = sums[x] * normalization;
+                }
+
+                const auto row_added = row( y + radius + 1 );
+                const auto row_removed = row( y - radius );
+                for( uint32_t x = 0; x < width; ++x )
+                {
+                    sums[x] += row_added[x] - row_removed[x];
+                }
+            }
+        } );
+    }
+
+    void convolve_rows( const double* source, double* target, uint32_t width, uint32_t height, const std::vector<double>& kernel )
+    {
+        const auto radius = static_cast<int64_t>( kernel.size() / 2 );
+        utility::iterate_parallel( height, [&] ( uint32_t y )
+        {
+            const auto row_source = source + size_t { y } * width;
+            const auto row_target = target + size_t { y } * width;
+            std::fill( row_target, row_target + width, 0.0 );
+
+            for( int64_t offset = -radius; offset <= radius; ++offset )
+            {
+                const auto weight = kernel[offset + radius];
+                const auto begin = std::clamp<int64_t>( -offset, 0, width );
+                const auto end = std::clamp<int64_t>( width - offset, 0, width );
+
+                for( int64_t x = 0; x < begin; ++x )
+                {
+                    row_target[x] += weight * row_source[0];
+                }
+                for( int64_t x = begin; x < end; ++x )
+                {
+                    row_target[x] += weight * row_source[x + offset];
+                }
+                for( int64_t x = end; x < width; ++x )
+                {
+                    row_target[x] += weight * row_source[width - 1];
+                }
+            }
+        } );
+    }
+    void convolve_columns( const double* source, double* target, uint32_t width, uint32_t height, const std::vector<double>& kernel )
+    {
+        const auto radius = static_cast<int64_t>( kernel.size() / 2 );
+        utility::iterate_parallel( height, [&] ( uint32_t y )
+        {
+            const auto row_target = target + size_t { y } * width;
+            std::fill( row_target, row_target + width, 0.0 );
+
+            for( int64_t offset = -radius; offset <= radius; ++offset )
+            {
+                const auto weight = kernel[offset + radius];
+                const auto row_source = source + static_cast<size_t>( std::clamp<int64_t>( y + offset, 0, height - 1 ) ) * width;
+                for( uint32_t x = 0; x < width; ++x )
+                {
+                    row_target[x] += weight * row_source[x];
+                }
+            }
+        } );
+    }
+
+    std::vector<double> gaussian_kernel( uint32_t radius )
+    {
+        const auto sigma = std::max( radius / 3.0, 0.5 );
+        auto kernel = std::vector<double>( 2 * radius + 1 );
+
+        auto sum = 0.0;
+        for( int64_t offset = -static_cast<int64_t>( radius ); offset <= radius; ++offset )
+        {
+            sum += kernel[offset + radius] = std::exp( -0.5 * offset * offset / ( sigma * sigma ) );
+        }
+        for( auto& weight : kernel )
+        {
+            weight /= sum;
+        }
+
+        return kernel;
+    }
+
+    // Huang's sliding histogram over values quantized to 4096 levels between the extremes, so the result is the median level rather than the exact median value
+    void median_filter( const double* source, double* target, uint32_t width, uint32_t height, uint32_t radius, Feature::Extremes extremes )
+    {
+        constexpr auto level_count = uint32_t { 4096 };
+        const auto element_count = size_t { width } * height;
+        const auto scale = extremes.maximum > extremes.minimum ? ( level_count - 1 ) / ( extremes.maximum - extremes.minimum ) : 0.0;
+        const auto inverse_scale = scale > 0.0 ? 1.0 / scale : 0.0;
+
+        auto levels = Array<uint16_t>::allocate( element_count );
+        utility::iterate_parallel( element_count, [&] ( size_t element_index )
+        {
+            const auto level = ( source[element_index] - extremes.minimum ) * scale + 0.5;
+            levels[element_index] = static_cast<uint16_t>( std::clamp( level, 0.0, level_count - 1.0 ) );
+        } );
+
+        const auto diameter = static_cast<int64_t>( 2 * radius + 1 );
+        const auto rank = static_cast<uint32_t>( diameter * diameter / 2 );
+
+        utility::iterate_parallel( height, [&] ( uint32_t y )
+        {
+            const auto sample = [&] ( int64_t x, int64_t offset )
+            {
+                const auto row_index = static_cast<size_t>( std::clamp<int64_t>( y + offset, 0, height - 1 ) );
+                return levels[row_index * width + std::clamp<int64_t>( x, 0, width - 1 )];
+            };
+
+            auto histogram = std::vector<uint32_t>( level_count, 0 );
+            for( int64_t offset = -static_cast<int64_t>( radius ); offset <= radius; ++offset )
+            {
+                for( int64_t x = -static_cast<int64_t>( radius ); x <= radius; ++x )
+                {
+                    ++histogram[sample( x, offset )];
+                }
+            }
+
+            auto median = uint32_t { 0 };
+            auto below = uint32_t { 0 };
+            const auto row_target = target + size_t { y } * width;
+
+            for( int64_t x = 0; x < width; ++x )
+            {
+                if( x > 0 )
+                {
+                    for( int64_t offset = -static_cast<int64_t>( radius ); offset <= radius; ++offset )
+                    {
+                        const auto removed = sample( x - radius - 1, offset );
+                        --histogram[removed];
+                        if( removed < median ) --below;
+
+                        const auto added = sample( x + radius, offset );
+                        ++histogram[added];
+                        if( added < median ) ++below;
+                    }
+                }
+
+                while( below > rank )
+                {
+                    below -= histogram[--median];
+                }
+                while( below + histogram[median] <= rank )
+                {
+                    below += histogram[median++];
+                }
+
+                row_target[x] = extremes.minimum + median * inverse_scale;
+            }
+        } );
     }
+}
+
+SpatialFilterFeature::SpatialFilterFeature( QSharedPointer<const Dataset> dataset, QSharedPointer<const Feature> feature, Filter filter, uint32_t radius )
+    : Feature {}, _dataset { dataset }
+{
+    this->update_feature( feature );
+    this->update_filter( filter );
+    this->update_radius( radius );
+
+    QObject::connect( this, &SpatialFilterFeature::feature_changed, &_values, &ComputedObject::invalidate );
+    QObject::connect( this, &SpatialFilterFeature::filter_changed, &_values, &ComputedObject::invalidate );
+    QObject::connect( this, &SpatialFilterFeature::radius_changed, &_values, &ComputedObject::invalidate );
+
+    QObject::connect( this, &SpatialFilterFeature::feature_changed, this, &SpatialFilterFeature::update_identifier );
+    QObject::connect( this, &SpatialFilterFeature::filter_changed, this, &SpatialFilterFeature::update_identifier );
+    QObject::connect( this, &SpatialFilterFeature::radius_changed, this, &SpatialFilterFeature::update_identifier );
+    this->update_identifier();
+}
+
+uint32_t SpatialFilterFeature::element_count() const noexcept
+{
+    const auto dataset = _dataset.lock();
+    return dataset ? dataset->element_count() : 0;
+}
+
+QSharedPointer<const Feature> SpatialFilterFeature::feature() const
+{
+    return _feature.lock();
+}
+void SpatialFilterFeature::update_feature( QSharedPointer<const Feature> feature )
+{
+    if( feature && feature->depends_on( this ) )
+    {
+        Console::warning( "SpatialFilterFeature::update_feature: Feature would depend on itself" );
+        return;
+    }
+    if( _feature != feature )
+    {
+        if( auto feature = _feature.lock() )
+        {
+            QObject::disconnect( feature.get(), nullptr, this, nullptr );
+        }
+
+        if( _feature = feature )
+        {
+            QObject::connect( feature.get(), &Feature::values_changed, &_values, &ComputedObject::invalidate );
+            QObject::connect( feature.get(), &Feature::identifier_changed, this, &SpatialFilterFeature::update_identifier );
+            QObject::connect( feature.get(), &Feature::destroyed, [this] { emit feature_changed( nullptr ); } );
+        }
+        emit feature_changed( feature );
+    }
+}
+
+SpatialFilterFeature::Filter SpatialFilterFeature::filter() const noexcept
+{
+    return _filter;
+}
+void SpatialFilterFeature::update_filter( Filter filter )
+{
+    if( _filter != filter )
+    {
+        _filter = filter;
+        emit filter_changed( _filter );
+    }
+}
+
+uint32_t SpatialFilterFeature::radius() const noexcept
+{
+    return _radius;
+}
+void SpatialFilterFeature::update_radius( uint32_t radius )
+{
+    if( _radius != radius )
+    {
+        _radius = radius;
+        emit radius_changed( _radius );
+    }
+}
+
+void SpatialFilterFeature::update_identifier()
+{
+    auto identifier = QString {};
+
+    if( _filter == Filter::eBox ) identifier += "Box";
+    else if( _filter == Filter::eGaussian ) identifier += "Gaussian";
+    else if( _filter == Filter::eMedian ) identifier += "Median";
+    else if( _filter == Filter::eGradientMagnitude ) identifier += "Gradient";
+    else if( _filter == Filter::eLocalVariance ) identifier += "Variance";
+
+    identifier += " r=" + QString::number( _radius ) + " (";
+    if( auto feature = _feature.lock() ) identifier += feature->identifier();
+    identifier += ')';
+
+    _identifier.update_automatic_value( identifier );
+}
+std::vector<QSharedPointer<const Feature>> SpatialFilterFeature::source_features() const
+{
+    return { _feature.lock() };
+}
+Feature::Values SpatialFilterFeature::compute_values() const
+{
+    Console::info( "SpatialFilterFeature::compute_values" );
+    auto values = this->allocate_values();
+
+    const auto dataset = _dataset.lock();
+    const auto feature = _feature.lock();
+    const auto spatial_metadata = dataset ? dataset->spatial_metadata() : nullptr;
+
+    if( !spatial_metadata || !feature )
+    {
+        return values;
+    }
+    if( feature->element_count() != this->element_count() || size_t { spatial_metadata->width } * spatial_metadata->height != this->element_count() )
+    {
+        Console::warning( "SpatialFilterFeature::compute_values: Feature does not match the image dimensions" );
+        return values;
+    }
+
+    const auto width = spatial_metadata->width;
+    const auto height = spatial_metadata->height;
+    const auto element_count = this->element_count();
+
+    auto source = Array<double>::allocate( element_count );
+    feature->visit_values( [&] ( const auto& feature_values )
+    {
+        utility::iterate_parallel( element_count, [&] ( uint32_t element_index )
+        {
+            source[element_index] = static_cast<double>( feature_values[element_index] );
+        } );
+    } );
+
+    auto result = Array<double>::allocate( element_count );
+    auto buffer = Array<double>::allocate( element_count );
+
+    if( _filter == Filter::eBox )
+    {
+        box_filter_rows( source.data(), buffer.data(), width, height, _radius );
+        box_filter_columns( buffer.data(), result.data(), width, height, _radius );
+    }
+    else if( _filter == Filter::eGaussian )
+    {
+        const auto kernel = gaussian_kernel( _radius );
+        convolve_rows( source.data(), buffer.data(), width, height, kernel );
+        convolve_columns( buffer.data(), result.data(), width, height, kernel );
+    }
+    else if( _filter == Filter::eMedian )
+    {
+        median_filter( source.data(), result.data(), width, height, _radius, feature->extremes() );
+    }
+    else if( _filter == Filter::eGradientMagnitude )
+    {
+        if( _radius > 0 )
+        {
+            const auto kernel = gaussian_kernel( _radius );
+            convolve_rows( source.data(), buffer.data(), width, height, kernel );
+            convolve_columns( buffer.data(), source.data(), width, height, kernel );
+        }
+
+        const auto smoothing = std::vector<double> { 0.25, 0.5, 0.25 };
+        const auto derivative = std::vector<double> { -0.5, 0.0, 0.5 };
+
+        auto gradient_y = Array<double>::allocate( element_count );
+        convolve_rows( source.data(), buffer.data(), width, height, derivative );
+        convolve_columns( buffer.data(), result.data(), width, height, smoothing );
+        convolve_rows( source.data(), buffer.data(), width, height, smoothing );
+        convolve_columns( buffer.data(), gradient_y.data(), width, height, derivative );
+
+        utility::iterate_parallel( element_count, [&] ( uint32_t element_index )
+        {
+            const auto gradient_x = result[element_index];
+            result[element_index] = std::sqrt( gradient_x * gradient_x + gradient_y[element_index] * gradient_y[element_index] );
+        } );
+    }
+    else if( _filter == Filter::eLocalVariance )
+    {
+        // Sums are taken around the global mean so that E[x^2] - E[x]^2 does not cancel for large offsets
+        const auto shift = feature->moments().average;
+        utility::iterate_parallel( element_count, [&] ( uint32_t element_index )
+        {
+            source[element_index] -= shift;
+        } );
+
+        box_filter_rows( source.data(), buffer.data(), width, height, _radius );
+        box_filter_columns( buffer.data(), result.data(), width, height, _radius );
+
+        utility::iterate_parallel( element_count, [&] ( uint32_t element_index )
+        {
+            source[element_index] *= source[element_index];
+        } );
+
+        auto squares = Array<double>::allocate( element_count );
+        box_filter_rows( source.data(), buffer.data(), width, height, _radius );
+        box_filter_columns( buffer.data(), squares.data(), width, height, _radius );
+
+        utility::iterate_parallel( element_count, [&] ( uint32_t element_index )
+        {
+            const auto mean = result[element_index];
+            result[element_index] = std::max( squares[element_index] - mean * mean, 0.0 );
+        } );
+    }
+    else
+    {
+        Console::error( "SpatialFilterFeature::compute_values: Unsupported filter" );
+    }
+
+    std::visit( [&] ( auto& values )
+    {
+        using value_type = typename std::remove_cvref_t<decltype( values )>::value_type;
+        utility::iterate_parallel( element_count, [&] ( uint32_t element_index )
+        {
+            values[element_index] = static_cast<value_type>( result[element_index] );
+        } );
+    }, values );
 
     return values;
-}
\ No newline at end of file
+}
@@ -1,6 +1,9 @@
 #pragma once
+#include "quantile_sketch.hpp"
 #include "utility.hpp"
 
+#include <variant>
+
 #include <qobject.h>
 
 class Dataset;
@@ -11,6 +14,14 @@ class Feature : public QObject
 {
     Q_OBJECT
 public:
+    enum class Precision
+    {
+        eDouble,
+        eSingle
+    };
+
+    using Values = std::variant<Array<double>, Array<float>>;
+
     struct Extremes
     {
         double minimum;
@@ -28,6 +39,7 @@ public:
         double lower_quartile;
         double median;
         double upper_quartile;
+        double rank_error;
     };
 
     Feature();
@@ -38,35 +50,68 @@ public:
     void update_identifier( const QString& identifier );
     Override<QString>& override_identifier() noexcept;
 
-    const Array<double>& values() const noexcept;
+    Precision precision() const noexcept;
+    void update_precision( Precision precision );
+
+    bool approximate_statistics() const noexcept;
+    void update_approximate_statistics( bool approximate_statistics );
+
+    // True if this feature is the given one or derives its values from it
+    bool depends_on( const Feature* feature ) const;
+
+    const Values& values() const noexcept;
+    const ComputedObject& computed_values() const noexcept;
+    bool values_present() const noexcept;
+    Values sampled_values( std::span<const uint32_t> element_indices ) const;
+    double value( uint32_t element_index ) const;
+    void visit_values( auto&& callable ) const;
+
     const Extremes& extremes() const noexcept;
     const Moments& moments() const noexcept;
     const Quantiles& quantiles() const noexcept;
     const Array<uint32_t>& sorted_indices() const noexcept;
+    const QuantileSketch& sketch() const noexcept;
 
 signals:
     void identifier_changed( const QString& identifier );
+    void precision_changed( Precision precision );
+    void approximate_statistics_changed( bool approximate_statistics );
     void values_changed();
     void extremes_changed();
     void moments_changed();
     void quantiles_changed();
     void sorted_indices_changed();
+    void sketch_changed();
 
 protected:
-    virtual Array<double> compute_values() const = 0;
+    virtual std::vector<QSharedPointer<const Feature>> source_features() const;
+    virtual Values compute_values() const = 0;
+    virtual Values compute_sampled_values( std::span<const uint32_t> element_indices ) const;
+    Values allocate_values() const;
+    Values allocate_values( uint32_t value_count ) const;
+
     Extremes compute_extremes() const;
     Moments compute_moments() const;
     Quantiles compute_quantiles() const;
     Array<uint32_t> compute_sorted_indices() const;
+    QuantileSketch compute_sketch() const;
 
     Override<QString> _identifier;
-    Computed<Array<double>> _values;
+    Precision _precision { Precision::eDouble };
+    bool _approximate_statistics = false;
+    Computed<Values> _values;
     Computed<Extremes> _extremes;
     Computed<Moments> _moments;
     Computed<Quantiles> _quantiles;
     Computed<Array<uint32_t>> _sorted_indices;
+    Computed<QuantileSketch> _sketch;
 };
 
+void Feature::visit_values( auto&& callable ) const
+{
+    std::visit( std::forward<decltype( callable )>( callable ), this->values() );
+}
+
 // ----- ElementFilterFeature ----- //
 
 class ElementFilterFeature : public Feature
@@ -78,7 +123,9 @@ public:
     uint32_t element_count() const noexcept override;
 
 private:
-    Array<double> compute_values() const override;
+    std::vector<QSharedPointer<const Feature>> source_features() const override;
+    Values compute_values() const override;
+    Values compute_sampled_values( std::span<const uint32_t> element_indices ) const override;
 
     QWeakPointer<const Feature> _feature;
     std::vector<uint32_t> _element_indices;
@@ -127,7 +174,9 @@ signals:
 
 private:
     void update_identifier();
-    Array<double> compute_values() const override;
+    Values compute_values() const override;
+    Values compute_sampled_values( std::span<const uint32_t> element_indices ) const override;
+    Values gather_values( std::span<const uint32_t> element_indices ) const;
 
     QWeakPointer<const Dataset> _dataset;
     Range<uint32_t> _channel_range;
@@ -169,9 +218,56 @@ signals:
 
 private:
     void update_identifier();
-    Array<double> compute_values() const override;
+    std::vector<QSharedPointer<const Feature>> source_features() const override;
+    Values compute_values() const override;
+    Values compute_sampled_values( std::span<const uint32_t> element_indices ) const override;
+    Values combine_values( const Values& first_feature_values, const Values& second_feature_values, uint32_t value_count ) const;
 
     QWeakPointer<const Feature> _first_feature;
     QWeakPointer<const Feature> _second_feature;
     Operation _operation { Operation::eAddition };
-};
\ No newline at end of file
+};
+
+// ----- SpatialFilterFeature ----- //
+
+class SpatialFilterFeature : public Feature
+{
+    Q_OBJECT
+public:
+    enum class Filter
+    {
+        eBox,
+        eGaussian,
+        eMedian,
+        eGradientMagnitude,
+        eLocalVariance
+    };
+
+    SpatialFilterFeature( QSharedPointer<const Dataset> dataset, QSharedPointer<const Feature> feature, Filter filter, uint32_t radius );
+
+    uint32_t element_count() const noexcept override;
+
+    QSharedPointer<const Feature> feature() const;
+    void update_feature( QSharedPointer<const Feature> feature );
+
+    Filter filter() const noexcept;
+    void update_filter( Filter filter );
+
+    uint32_t radius() const noexcept;
+    void update_radius( uint32_t radius );
+
+signals:
+    void feature_changed( QSharedPointer<const Feature> feature );
+    void filter_changed( Filter filter );
+    void radius_changed( uint32_t radius );
+
+private:
+    void update_identifier();
+    std::vector<QSharedPointer<const Feature>> source_features() const override;
+    Values compute_values() const override;
+
+    QWeakPointer<const Dataset> _dataset;
+    QWeakPointer<const Feature> _feature;
+    Filter _filter { Filter::eBox };
+    uint32_t _radius = 1;
+};
@@ -11,6 +11,7 @@
 #include <qlineedit.h>
 #include <qmessagebox.h>
 #include <qpushbutton.h>
+#include <qspinbox.h>
 #include <qtoolbutton.h>
 
 FeatureManager::FeatureManager( Database& database ) : QDialog {}, _database { database }
@@ -59,6 +60,19 @@ FeatureManager::FeatureManager( Database& database ) : QDialog {}, _database { d
             };
             _database.features()->append( QSharedPointer<Feature> { feature } );
         } );
+        if( _database.dataset()->spatial_metadata() )
+        {
+            context_menu.addAction( "Spatial Filter Feature", [this]
+            {
+                auto feature = new SpatialFilterFeature {
+                    _database.dataset(),
+                    QSharedPointer<const Feature> {},
+                    SpatialFilterFeature::Filter::eGaussian,
+                    2
+                };
+                _database.features()->append( QSharedPointer<Feature> { feature } );
+            } );
+        }
 
         context_menu.setFixedWidth( button_create_feature->width() );
         context_menu.exec( button_create_feature->mapToGlobal( QPoint { 0, button_create_feature->height() } ) );
@@ -85,6 +99,18 @@ void FeatureManager::feature_appended( QSharedPointer<QObject> object )
 
     auto lineedit_identfier = new StringInput { feature->override_identifier() };
 
+    auto combobox_precision = new QComboBox {};
+    combobox_precision->addItem( "Double", QVariant::fromValue( Feature::Precision::eDouble ) );
+    combobox_precision->addItem( "Single", QVariant::fromValue( Feature::Precision::eSingle ) );
+    combobox_precision->setCurrentIndex( combobox_precision->findData( QVariant::fromValue( feature->precision() ) ) );
+    combobox_precision->setToolTip( "Storage precision of the feature values" );
+
+    auto combobox_statistics = new QComboBox {};
+    combobox_statistics->addItem( "Exact", false );
+    combobox_statistics->addItem( "Approximate", true );
+    combobox_statistics->setCurrentIndex( combobox_statistics->findData( feature->approximate_statistics() ) );
+    combobox_statistics->setToolTip( "Quantiles from sorting all values or from a quantile sketch with bounded rank error" );
+
     auto button_remove = new QToolButton {};
     button_remove->setIcon( QIcon { ":/delete.svg" } );
 
@@ -92,8 +118,25 @@ void FeatureManager::feature_appended( QSharedPointer<QObject> object )
     header->setContentsMargins( 0, 0, 0, 0 );
     header->setSpacing( 5 );
     header->addWidget( lineedit_identfier );
+    header->addWidget( combobox_precision );
+    header->addWidget( combobox_statistics );
     header->addWidget( button_remove );
 
+    QObject::connect( combobox_precision, &QComboBox::currentIndexChanged, this, [pointer = QWeakPointer { feature }, combobox_precision] ( int index )
+    {
+        if( auto feature = pointer.lock() )
+        {
+            feature->update_precision( combobox_precision->itemData( index ).value<Feature::Precision>() );
+        }
+    } );
+    QObject::connect( combobox_statistics, &QComboBox::currentIndexChanged, this, [pointer = QWeakPointer { feature }, combobox_statistics] ( int index )
+    {
+        if( auto feature = pointer.lock() )
+        {
+            feature->update_approximate_statistics( combobox_statistics->itemData( index ).toBool() );
+        }
+    } );
+
     auto properties = new QVBoxLayout {};
     properties->setContentsMargins( 20, 0, 0, 0 );
     properties->setSpacing( 2 );
@@ -102,7 +145,7 @@ void FeatureManager::feature_appended( QSharedPointer<QObject> object )
     {
         auto first = new FeatureSelector { _database.features(), [pointer = combination_feature.get()] ( QSharedPointer<const Feature> feature )
         {
-            return feature.get() != pointer;
+            return !feature->depends_on( pointer );
         } };
         first->update_selected_feature( combination_feature->first_feature().constCast<Feature>() );
 
@@ -115,7 +158,7 @@ void FeatureManager::feature_appended( QSharedPointer<QObject> object )
 
         auto second = new FeatureSelector { _database.features(), [pointer = combination_feature.get()] ( QSharedPointer<const Feature> feature )
         {
-            return feature.get() != pointer;
+            return !feature->depends_on( pointer );
         } };
         second->update_selected_feature( combination_feature->second_feature().constCast<Feature>() );
 
@@ -143,6 +186,51 @@ void FeatureManager::feature_appended( QSharedPointer<QObject> object )
 
         properties->addLayout( row );
     }
+    else if( auto spatial_filter_feature = feature.objectCast<SpatialFilterFeature>() )
+    {
+        auto source = new FeatureSelector { _database.features(), [pointer = spatial_filter_feature.get()] ( QSharedPointer<const Feature> feature )
+        {
+            return !feature->depends_on( pointer );
+        } };
+        source->update_selected_feature( spatial_filter_feature->feature().constCast<Feature>() );
+
+        auto filter = new QComboBox {};
+        filter->addItem( "Box", QVariant::fromValue( SpatialFilterFeature::Filter::eBox ) );
+        filter->addItem( "Gaussian", QVariant::fromValue( SpatialFilterFeature::Filter::eGaussian ) );
+        filter->addItem( "Median (Quantized)", QVariant::fromValue( SpatialFilterFeature::Filter::eMedian ) );
+        filter->setItemData( filter->count() - 1, "Median of the values quantized to 4096 levels between the extremes", Qt::ToolTipRole );
+        filter->addItem( "Gradient Magnitude", QVariant::fromValue( SpatialFilterFeature::Filter::eGradientMagnitude ) );
+        filter->addItem( "Local Variance", QVariant::fromValue( SpatialFilterFeature::Filter::eLocalVariance ) );
+        filter->setCurrentIndex( filter->findData( QVariant::fromValue( spatial_filter_feature->filter() ) ) );
+
+        auto radius = new QSpinBox {};
+        radius->setRange( 0, 100 );
+        radius->setValue( spatial_filter_feature->radius() );
+        radius->setPrefix( "r = " );
+
+        QObject::connect( source, &FeatureSelector::selected_feature_changed, this, [this, spatial_filter_feature] ( QSharedPointer<const Feature> feature )
+        {
+            spatial_filter_feature->update_feature( feature );
+        } );
+        QObject::connect( filter, &QComboBox::currentIndexChanged, this, [this, spatial_filter_feature, filter] ( int index )
+        {
+            spatial_filter_feature->update_filter( filter->itemData( index ).value<SpatialFilterFeature::Filter>() );
+        } );
+        QObject::connect( radius, qOverload<int>( &QSpinBox::valueChanged ), this, [this, spatial_filter_feature] ( int value )
+        {
+            spatial_filter_feature->update_radius( static_cast<uint32_t>( value ) );
+        } );
+
+        auto row = new QHBoxLayout {};
+        row->setContentsMargins( 0, 0, 0, 0 );
+        row->setSpacing( 5 );
+
+        row->addWidget( source, 1 );
+        row->addWidget( filter );
+        row->addWidget( radius );
+
+        properties->addLayout( row );
+    }
 
     auto container_widget = new QWidget {};
     auto container_layout = new QVBoxLayout { container_widget };
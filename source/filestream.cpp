@@ -1,6 +1,7 @@
 #include "filestream.hpp"
 
 #include "dataset.hpp"
+#include "dataset_importer.hpp"
 
 #include <ranges>
 #include <regex>
@@ -79,7 +80,8 @@ template<> BinaryStream& BinaryStream::read( BinaryStream& stream, QSharedPointe
     auto matches = std::smatch {};
     if( !std::regex_match( identifier, matches, identifier_regex ) )
     {
-        QMessageBox::critical( nullptr, "", "Invalid dataset file.", QMessageBox::Ok );
+        Console::error( "Invalid dataset file" );
+        if( DatasetImporter::interactive ) QMessageBox::critical( nullptr, "", "Invalid dataset file.", QMessageBox::Ok );
         return stream;
     }
 
@@ -94,7 +96,8 @@ template<> BinaryStream& BinaryStream::read( BinaryStream& stream, QSharedPointe
         else if( attribute == "SpatialMetadata" ) attribute_spatial_metadata = true;
         else
         {
-            QMessageBox::warning( nullptr, "", "Unknown dataset attribute: " + QString::fromStdString( attribute ), QMessageBox::Ok );
+            Console::warning( "Unknown dataset attribute: " + attribute );
+            if( DatasetImporter::interactive ) QMessageBox::warning( nullptr, "", "Unknown dataset attribute: " + QString::fromStdString( attribute ), QMessageBox::Ok );
             return stream;
         }
     }
@@ -156,7 +159,8 @@ template<> BinaryStream& BinaryStream::read( BinaryStream& stream, QSharedPointe
     }
     else
     {
-        QMessageBox::critical( nullptr, "", "Unsupported dataset value type.", QMessageBox::Ok );
+        Console::error( "Unsupported dataset value type" );
+        if( DatasetImporter::interactive ) QMessageBox::critical( nullptr, "", "Unsupported dataset value type.", QMessageBox::Ok );
         return stream;
     }
 
@@ -3,19 +3,152 @@
 #include "feature.hpp"
 #include "segmentation.hpp"
 
+#include <thread>
+
+namespace
+{
+    constexpr auto histogram_minimum_chunk_size = uint32_t { 1 << 16 };
+    constexpr auto histogram_maximum_private_counts = uint32_t { 1 << 24 };
+
+    // Bins elements into per-chunk private counts which are merged afterwards, counts are laid out as segments x bins
+    void accumulate_counts( uint32_t element_count, const uint32_t* segment_numbers, uint32_t bincount, Array<uint32_t>& counts, auto&& bin_index )
+    {
+        const auto stride = static_cast<uint32_t>( counts.size() );
+        if( element_count == 0 || stride == 0 )
+        {
+            return;
+        }
+
+        const auto chunk_limit = std::min( std::max( std::thread::hardware_concurrency(), 1u ), std::max( histogram_maximum_private_counts / stride, 1u ) );
+        const auto chunk_count = std::clamp( element_count / histogram_minimum_chunk_size, 1u, chunk_limit );
+        const auto chunk_size = ( element_count + chunk_count - 1 ) / chunk_count;
+
+        auto chunk_counts = Array<uint32_t> { size_t { chunk_count } * stride, 0 };
+
+        utility::iterate_parallel( chunk_count, [&] ( uint32_t chunk_index )
+        {
+            const auto begin = std::min( chunk_index * chunk_size, element_count );
+            const auto end = std::min( begin + chunk_size, element_count );
+            const auto private_counts = chunk_counts.data() + size_t { chunk_index } * stride;
+
+            if( segment_numbers )
+            {
+                for( uint32_t element_index = begin; element_index < end; ++element_index )
+                {
+                    ++private_counts[segment_numbers[element_index] * bincount + bin_index( element_index )];
+                }
+            }
+            else
+            {
+                for( uint32_t element_index = begin; element_index < end; ++element_index )
+                {
+                    ++private_counts[bin_index( element_index )];
+                }
+            }
+        } );
+
+        utility::iterate_parallel( stride, [&] ( uint32_t index )
+        {
+            auto count = uint32_t { 0 };
+            for( uint32_t chunk_index = 0; chunk_index < chunk_count; ++chunk_index )
+            {
+                count += chunk_counts[size_t { chunk_index } * stride + index];
+            }
+            counts[index] = count;
+        } );
+    }
+
+    Range<double> feature_range( const QSharedPointer<const Feature>& feature )
+    {
+        auto range = Range<double> { 0.0, 1.0 };
+        if( feature )
+        {
+            const auto& extremes = feature->extremes();
+            range = Range<double> { extremes.minimum, extremes.maximum };
+        }
+
+        if( range.lower == range.upper )
+        {
+            range.upper += 1.0;
+        }
+
+        return range;
+    }
+
+    Array<double> compute_range_edges( Range<double> range, uint32_t bincount )
+    {
+        auto edges = Array<double> { bincount + 1, 0.0 };
+
+        const auto binsize = ( range.upper - range.lower ) / bincount;
+        for( uint32_t i = 0; i <= bincount; ++i )
+        {
+            edges[i] = std::clamp( range.lower + i * binsize, range.lower, range.upper );
+        }
+
+        return edges;
+    }
+
+    // Maps values to equally sized bins over the range, values outside of it fall into the first or last bin
+    auto bin_mapping( Range<double> range, uint32_t bincount )
+    {
+        const auto scale = bincount / ( range.upper - range.lower );
+        const auto upper = static_cast<double>( bincount - 1 );
+        return [=] ( double value )
+        {
+            return static_cast<uint32_t>( std::clamp( ( value - range.lower ) * scale, 0.0, upper ) );
+        };
+    }
+
+    // Re-aggregates base counts into the bincount, exact if it divides the base bincount, otherwise base bins straddling an edge are split proportionally
+    void redistribute_counts( const uint32_t* base_counts, uint32_t bincount, uint32_t* counts )
+    {
+        constexpr auto base_bincount = Histogram::base_bincount;
+
+        auto base_index = uint32_t { 0 };
+        auto cumulative = uint64_t { 0 };
+
+        // Edges lie at bin * base_bincount / bincount base bins, kept as integer quotient and remainder
+        const auto cumulative_count = [&] ( uint32_t bin )
+        {
+            const auto position = uint64_t { bin } * base_bincount;
+            const auto edge_index = static_cast<uint32_t>( position / bincount );
+            while( base_index < edge_index )
+            {
+                cumulative += base_counts[base_index++];
+            }
+
+            const auto remainder = position % bincount;
+            const auto fraction = remainder && base_index < base_bincount ? static_cast<double>( remainder ) / bincount * base_counts[base_index] : 0.0;
+            return static_cast<uint64_t>( std::llround( cumulative + fraction ) );
+        };
+
+        auto previous = cumulative_count( 0 );
+        for( uint32_t bin = 0; bin < bincount; ++bin )
+        {
+            const auto current = cumulative_count( bin + 1 );
+            counts[bin] = static_cast<uint32_t>( current - previous );
+            previous = current;
+        }
+    }
+}
+
+
 // ----- Histogram ----- //
 
 Histogram::Histogram( uint32_t bincount ) : QObject {}, _bincount { bincount }
 {
     _edges.initialize( std::bind( &Histogram::compute_edges, this ) );
+    _base_counts.initialize( std::bind( &Histogram::compute_base_counts, this ) );
     _counts.initialize( std::bind( &Histogram::compute_counts, this ) );
 
     QObject::connect( this, &Histogram::feature_changed, &_edges, &ComputedObject::invalidate );
-    QObject::connect( this, &Histogram::feature_changed, &_counts, &ComputedObject::invalidate );
+    QObject::connect( this, &Histogram::feature_changed, &_base_counts, &ComputedObject::invalidate );
 
     QObject::connect( this, &Histogram::bincount_changed, &_edges, &ComputedObject::invalidate );
     QObject::connect( this, &Histogram::bincount_changed, &_counts, &ComputedObject::invalidate );
 
+    QObject::connect( &_base_counts, &ComputedObject::changed, &_counts, &ComputedObject::invalidate );
+
     QObject::connect( &_edges, &ComputedObject::changed, this, &Histogram::edges_changed );
     QObject::connect( &_counts, &ComputedObject::changed, this, &Histogram::counts_changed );
 }
@@ -36,7 +169,7 @@ void Histogram::update_feature( QSharedPointer<const Feature> feature )
         if( _feature = feature )
         {
             QObject::connect( feature.get(), &Feature::values_changed, &_edges, &ComputedObject::invalidate );
-            QObject::connect( feature.get(), &Feature::values_changed, &_counts, &ComputedObject::invalidate );
+            QObject::connect( feature.get(), &Feature::values_changed, &_base_counts, &ComputedObject::invalidate );
             QObject::connect( feature.get(), &QObject::destroyed, this, [this] { emit feature_changed( nullptr ); } );
         }
 
@@ -65,53 +198,45 @@ const Array<uint32_t>& Histogram::counts() const
 {
     return *_counts;
 }
+bool Histogram::exact() const noexcept
+{
+    return base_bincount % _bincount == 0;
+}
 
+Range<double> Histogram::compute_range() const
+{
+    return feature_range( _feature.lock() );
+}
 Array<double> Histogram::compute_edges() const
 {
     Console::info( "Histogram::compute_edges" );
-    auto edges = Array<double> { _bincount + 1, 0.0 };
+    return compute_range_edges( this->compute_range(), _bincount );
+}
+Array<uint32_t> Histogram::compute_base_counts() const
+{
+    Console::info( "Histogram::compute_base_counts" );
+    auto base_counts = Array<uint32_t> { base_bincount, 0 };
 
-    auto minimum = 0.0;
-    auto maximum = 1.0;
     if( auto feature = _feature.lock() )
     {
-        const auto& extremes = feature->extremes();
-        minimum = extremes.minimum;
-        maximum = extremes.maximum;
-    }
-
-    if( minimum == maximum )
-    {
-        maximum += 1.0;
-    }
-
-    const auto binsize = ( maximum - minimum ) / _bincount;
-    for( uint32_t i = 0; i <= _bincount; ++i )
-    {
-        const auto edge = std::clamp( minimum + i * binsize, minimum, maximum );
-        edges[i] = edge;
+        const auto bin_index = bin_mapping( this->compute_range(), base_bincount );
+        feature->visit_values( [&] ( const auto& values )
+        {
+            accumulate_counts( feature->element_count(), nullptr, base_bincount, base_counts, [&] ( uint32_t element_index )
+            {
+                return bin_index( values[element_index] );
+            } );
+        } );
     }
 
-    return edges;
+    return base_counts;
 }
 Array<uint32_t> Histogram::compute_counts() const
 {
     Console::info( "Histogram::compute_counts" );
     auto counts = Array<uint32_t> { _bincount, 0 };
 
-    if( auto feature = _feature.lock() )
-    {
-        const auto& edges = this->edges();
-        const auto& values = feature->values();
-
-        const auto minimum = edges[0];
-        const auto binsize = edges[1] - edges[0];
-
-        for( const auto value : values )
-        {
-            ++counts[std::clamp( static_cast<uint32_t>( ( value - minimum ) / binsize ), 0u, _bincount - 1 )];
-        }
-    }
+    redistribute_counts( _base_counts->data(), _bincount, counts.data() );
 
     return counts;
 }
@@ -121,15 +246,20 @@ Array<uint32_t> Histogram::compute_counts() const
 StackedHistogram::StackedHistogram( uint32_t bincount ) : QObject {}, _bincount { bincount }
 {
     _edges.initialize( std::bind( &StackedHistogram::compute_edges, this ) );
+    _base_counts.initialize( std::bind( &StackedHistogram::compute_base_counts, this ) );
+    _bin_indices.initialize( std::bind( &StackedHistogram::compute_bin_indices, this ) );
     _counts.initialize( std::bind( &StackedHistogram::compute_counts, this ) );
 
     QObject::connect( this, &StackedHistogram::feature_changed, &_edges, &ComputedObject::invalidate );
-    QObject::connect( this, &StackedHistogram::feature_changed, &_counts, &ComputedObject::invalidate );
+    QObject::connect( this, &StackedHistogram::feature_changed, &_bin_indices, &ComputedObject::invalidate );
 
     QObject::connect( this, &StackedHistogram::bincount_changed, &_edges, &ComputedObject::invalidate );
     QObject::connect( this, &StackedHistogram::bincount_changed, &_counts, &ComputedObject::invalidate );
 
-    QObject::connect( this, &StackedHistogram::segmentation_changed, &_counts, &ComputedObject::invalidate );
+    QObject::connect( this, &StackedHistogram::segmentation_changed, &_base_counts, &ComputedObject::invalidate );
+
+    QObject::connect( &_bin_indices, &ComputedObject::changed, &_base_counts, &ComputedObject::invalidate );
+    QObject::connect( &_base_counts, &ComputedObject::changed, &_counts, &ComputedObject::invalidate );
 
     QObject::connect( &_edges, &ComputedObject::changed, this, &StackedHistogram::edges_changed );
     QObject::connect( &_counts, &ComputedObject::changed, this, &StackedHistogram::counts_changed );
@@ -149,8 +279,8 @@ void StackedHistogram::update_segmentation( QSharedPointer<const Segmentation> s
         }
         if( _segmentation = segmentation )
         {
-            QObject::connect( segmentation.get(), &Segmentation::segment_numbers_changed, &_counts, &ComputedObject::invalidate );
-            QObject::connect( segmentation.get(), &Segmentation::segment_count_changed, &_counts, &ComputedObject::invalidate );
+            QObject::connect( segmentation.get(), &Segmentation::segment_numbers_changed, this, &StackedHistogram::on_segment_numbers_changed );
+            QObject::connect( segmentation.get(), &Segmentation::segment_count_changed, &_base_counts, &ComputedObject::invalidate );
         }
         emit segmentation_changed( segmentation );
     }
@@ -172,7 +302,7 @@ void StackedHistogram::update_feature( QSharedPointer<const Feature> feature )
         if( _feature = feature )
         {
             QObject::connect( feature.get(), &Feature::values_changed, &_edges, &ComputedObject::invalidate );
-            QObject::connect( feature.get(), &Feature::values_changed, &_counts, &ComputedObject::invalidate );
+            QObject::connect( feature.get(), &Feature::values_changed, &_bin_indices, &ComputedObject::invalidate );
             QObject::connect( feature.get(), &QObject::destroyed, this, [this] { emit feature_changed( nullptr ); } );
         }
 
@@ -197,65 +327,354 @@ const Array<double>& StackedHistogram::edges() const
 {
     return *_edges;
 }
-const Array<Array<uint32_t>>& StackedHistogram::counts() const
+const Array<uint32_t>& StackedHistogram::counts() const
 {
     return *_counts;
 }
+std::span<const uint32_t> StackedHistogram::counts( uint32_t segment_number ) const
+{
+    return std::span<const uint32_t> { this->counts().data() + size_t { segment_number } * _bincount, _bincount };
+}
+bool StackedHistogram::exact() const noexcept
+{
+    return Histogram::base_bincount % _bincount == 0;
+}
 
+Range<double> StackedHistogram::compute_range() const
+{
+    return feature_range( _feature.lock() );
+}
 Array<double> StackedHistogram::compute_edges() const
 {
     Console::info( "StackedHistogram::compute_edges" );
-    auto edges = Array<double> { _bincount + 1, 0.0 };
+    return compute_range_edges( this->compute_range(), _bincount );
+}
+Array<uint32_t> StackedHistogram::compute_base_counts() const
+{
+    Console::info( "StackedHistogram::compute_base_counts" );
+    auto base_counts = Array<uint32_t> {};
 
-    auto minimum = 0.0;
-    auto maximum = 1.0;
-    if( auto feature = _feature.lock() )
+    if( const auto segmentation = _segmentation.lock() )
     {
-        const auto& extremes = feature->extremes();
-        minimum = extremes.minimum;
-        maximum = extremes.maximum;
+        base_counts = Array<uint32_t> { size_t { segmentation->segment_count() } * Histogram::base_bincount, 0 };
+
+        if( const auto feature = _feature.lock() )
+        {
+            const auto& bin_indices = *_bin_indices;
+            const auto element_count = std::min( static_cast<uint32_t>( bin_indices.size() ), segmentation->element_count() );
+
+            accumulate_counts( element_count, segmentation->segment_numbers().data(), Histogram::base_bincount, base_counts, [&bin_indices] ( uint32_t element_index )
+            {
+                return uint32_t { bin_indices[element_index] };
+            } );
+        }
     }
 
-    if( minimum == maximum )
+    return base_counts;
+}
+Array<uint16_t> StackedHistogram::compute_bin_indices() const
+{
+    Console::info( "StackedHistogram::compute_bin_indices" );
+    auto bin_indices = Array<uint16_t> {};
+
+    if( const auto feature = _feature.lock() )
     {
-        maximum += 1.0;
-    }
+        bin_indices = Array<uint16_t>::allocate( feature->element_count() );
 
-    const auto binsize = ( maximum - minimum ) / _bincount;
+        const auto bin_index = bin_mapping( this->compute_range(), Histogram::base_bincount );
+        feature->visit_values( [&] ( const auto& values )
+        {
+            utility::iterate_parallel( feature->element_count(), [&] ( uint32_t element_index )
+            {
+                bin_indices[element_index] = static_cast<uint16_t>( bin_index( values[element_index] ) );
+            } );
+        } );
+    }
 
-    for( uint32_t i = 0; i <= _bincount; ++i )
+    return bin_indices;
+}
+void StackedHistogram::on_segment_numbers_changed()
+{
+    const auto segmentation = _segmentation.lock();
+    if( !segmentation || segmentation->full_change() || !_bin_indices.present() )
     {
-        const auto edge = std::clamp( minimum + i * binsize, minimum, maximum );
-        edges[i] = edge;
+        _base_counts.invalidate();
+        return;
     }
 
-    return edges;
+    // Edits move elements between segments without changing their bins, so only the affected counts are updated
+    const auto updated = _base_counts.modify( [&] ( Array<uint32_t>& base_counts )
+    {
+        const auto& bin_indices = *_bin_indices;
+        for( const auto& change : segmentation->changes() )
+        {
+            if( change.element_index < bin_indices.size() )
+            {
+                const auto bin_index = bin_indices[change.element_index];
+                --base_counts[size_t { change.previous_segment_number } * Histogram::base_bincount + bin_index];
+                ++base_counts[size_t { change.segment_number } * Histogram::base_bincount + bin_index];
+            }
+        }
+    } );
+
+    if( !updated )
+    {
+        _base_counts.invalidate();
+    }
 }
-Array<Array<uint32_t>> StackedHistogram::compute_counts() const
+Array<uint32_t> StackedHistogram::compute_counts() const
 {
     Console::info( "StackedHistogram::compute_counts" );
-    auto counts = Array<Array<uint32_t>> {};
+    const auto& base_counts = *_base_counts;
+    const auto segment_count = static_cast<uint32_t>( base_counts.size() / Histogram::base_bincount );
+    auto counts = Array<uint32_t> { size_t { segment_count } * _bincount, 0 };
 
-    if( const auto segmentation = _segmentation.lock() )
+    for( uint32_t segment_number = 0; segment_number < segment_count; ++segment_number )
     {
-        counts = Array<Array<uint32_t>> { segmentation->segment_count(), Array<uint32_t> { _bincount, 0 } };
+        redistribute_counts( base_counts.data() + size_t { segment_number } * Histogram::base_bincount, _bincount, counts.data() + size_t { segment_number } * _bincount );
+    }
 
-        if( const auto feature = _feature.lock() )
+    return counts;
+}
+
+// ----- Histogram2D ----- //
+
+Histogram2D::Histogram2D( uint32_t resolution ) : QObject {}, _resolution { std::max( resolution, 1u ) }
+{
+    _counts.initialize( std::bind( &Histogram2D::compute_counts, this ) );
+    _total_counts.initialize( std::bind( &Histogram2D::compute_total_counts, this ) );
+    _densities.initialize( std::bind( &Histogram2D::compute_densities, this ) );
+
+    QObject::connect( this, &Histogram2D::xfeature_changed, &_counts, &ComputedObject::invalidate );
+    QObject::connect( this, &Histogram2D::yfeature_changed, &_counts, &ComputedObject::invalidate );
+    QObject::connect( this, &Histogram2D::segmentation_changed, &_counts, &ComputedObject::invalidate );
+    QObject::connect( this, &Histogram2D::resolution_changed, &_counts, &ComputedObject::invalidate );
+    QObject::connect( this, &Histogram2D::logarithmic_changed, &_densities, &ComputedObject::invalidate );
+
+    QObject::connect( &_counts, &ComputedObject::changed, &_total_counts, &ComputedObject::invalidate );
+    QObject::connect( &_total_counts, &ComputedObject::changed, &_densities, &ComputedObject::invalidate );
+
+    QObject::connect( &_counts, &ComputedObject::changed, this, &Histogram2D::counts_changed );
+    QObject::connect( &_densities, &ComputedObject::changed, this, &Histogram2D::densities_changed );
+}
+
+QSharedPointer<const Feature> Histogram2D::xfeature() const
+{
+    return _xfeature.lock();
+}
+void Histogram2D::update_xfeature( QSharedPointer<const Feature> feature )
+{
+    if( _xfeature != feature )
+    {
+        // Only this axis' connections are dropped, the other axis may use the same feature
+        for( const auto& connection : _xfeature_connections )
         {
-            const auto& edges = this->edges();
-            const auto& values = feature->values();
+            QObject::disconnect( connection );
+        }
 
-            const auto minimum = edges[0];
-            const auto binsize = edges[1] - edges[0];
+        if( _xfeature = feature )
+        {
+            _xfeature_connections = {
+                QObject::connect( feature.get(), &Feature::values_changed, &_counts, &ComputedObject::invalidate ),
+                QObject::connect( feature.get(), &QObject::destroyed, this, [this] { emit xfeature_changed( nullptr ); } )
+            };
+        }
 
-            for( uint32_t element_index = 0; element_index < feature->element_count(); ++element_index )
-            {
-                const auto segment_number = segmentation->segment_number( element_index );
-                const auto value = values[element_index];
-                ++counts[segment_number][std::clamp( static_cast<uint32_t>( ( value - minimum ) / binsize ), 0u, _bincount - 1 )];
-            }
+        emit xfeature_changed( feature );
+    }
+}
+
+QSharedPointer<const Feature> Histogram2D::yfeature() const
+{
+    return _yfeature.lock();
+}
+void Histogram2D::update_yfeature( QSharedPointer<const Feature> feature )
+{
+    if( _yfeature != feature )
+    {
+        // Only this axis' connections are dropped, the other axis may use the same feature
+        for( const auto& connection : _yfeature_connections )
+        {
+            QObject::disconnect( connection );
         }
+
+        if( _yfeature = feature )
+        {
+            _yfeature_connections = {
+                QObject::connect( feature.get(), &Feature::values_changed, &_counts, &ComputedObject::invalidate ),
+                QObject::connect( feature.get(), &QObject::destroyed, this, [this] { emit yfeature_changed( nullptr ); } )
+            };
+        }
+
+        emit yfeature_changed( feature );
+    }
+}
+
+QSharedPointer<const Segmentation> Histogram2D::segmentation() const
+{
+    return _segmentation.lock();
+}
+void Histogram2D::update_segmentation( QSharedPointer<const Segmentation> segmentation )
+{
+    if( _segmentation != segmentation )
+    {
+        if( auto segmentation = _segmentation.lock() )
+        {
+            QObject::disconnect( segmentation.get(), nullptr, this, nullptr );
+        }
+        if( _segmentation = segmentation )
+        {
+            QObject::connect( segmentation.get(), &Segmentation::segment_numbers_changed, &_counts, &ComputedObject::invalidate );
+            QObject::connect( segmentation.get(), &Segmentation::segment_count_changed, &_counts, &ComputedObject::invalidate );
+        }
+        emit segmentation_changed( segmentation );
+    }
+}
+
+uint32_t Histogram2D::resolution() const noexcept
+{
+    return _resolution;
+}
+void Histogram2D::update_resolution( uint32_t resolution )
+{
+    resolution = std::max( resolution, 1u );
+    if( _resolution != resolution )
+    {
+        _resolution = resolution;
+        emit resolution_changed( _resolution );
     }
+}
+
+bool Histogram2D::logarithmic() const noexcept
+{
+    return _logarithmic;
+}
+void Histogram2D::update_logarithmic( bool logarithmic )
+{
+    if( _logarithmic != logarithmic )
+    {
+        _logarithmic = logarithmic;
+        emit logarithmic_changed( _logarithmic );
+    }
+}
+
+Range<double> Histogram2D::xrange() const
+{
+    return feature_range( _xfeature.lock() );
+}
+Range<double> Histogram2D::yrange() const
+{
+    return feature_range( _yfeature.lock() );
+}
+std::optional<uint32_t> Histogram2D::cell_index( double x, double y ) const
+{
+    const auto xrange = this->xrange();
+    const auto yrange = this->yrange();
+    if( x < xrange.lower || x > xrange.upper || y < yrange.lower || y > yrange.upper )
+    {
+        return std::nullopt;
+    }
+
+    const auto upper = static_cast<double>( _resolution - 1 );
+    const auto column = static_cast<uint32_t>( std::clamp( ( x - xrange.lower ) * _resolution / ( xrange.upper - xrange.lower ), 0.0, upper ) );
+    const auto row = static_cast<uint32_t>( std::clamp( ( y - yrange.lower ) * _resolution / ( yrange.upper - yrange.lower ), 0.0, upper ) );
+    return row * _resolution + column;
+}
+
+const Array<uint32_t>& Histogram2D::counts() const
+{
+    return *_counts;
+}
+std::span<const uint32_t> Histogram2D::counts( uint32_t segment_number ) const
+{
+    const auto cell_count = size_t { _resolution } * _resolution;
+    return std::span<const uint32_t> { this->counts().data() + segment_number * cell_count, cell_count };
+}
+const Array<uint32_t>& Histogram2D::total_counts() const
+{
+    return *_total_counts;
+}
+const Array<float>& Histogram2D::densities() const
+{
+    return *_densities;
+}
+
+Array<uint32_t> Histogram2D::compute_counts() const
+{
+    Console::info( "Histogram2D::compute_counts" );
+    const auto cell_count = _resolution * _resolution;
+
+    const auto xfeature = _xfeature.lock();
+    const auto yfeature = _yfeature.lock();
+    if( !xfeature || !yfeature || xfeature->element_count() != yfeature->element_count() )
+    {
+        return Array<uint32_t> { cell_count, 0 };
+    }
+
+    // Stacking by segment requires the segmentation to cover the same elements as the features
+    const auto element_count = xfeature->element_count();
+    auto segment_numbers = static_cast<const uint32_t*>( nullptr );
+    auto segment_count = uint32_t { 1 };
+    if( const auto segmentation = _segmentation.lock(); segmentation && segmentation->element_count() == element_count )
+    {
+        segment_numbers = segmentation->segment_numbers().data();
+        segment_count = segmentation->segment_count();
+    }
+
+    auto counts = Array<uint32_t> { size_t { segment_count } * cell_count, 0 };
+
+    const auto xrange = this->xrange();
+    const auto yrange = this->yrange();
+    const auto xscale = _resolution / ( xrange.upper - xrange.lower );
+    const auto yscale = _resolution / ( yrange.upper - yrange.lower );
+    const auto upper = static_cast<double>( _resolution - 1 );
+
+    std::visit( [&] ( const auto& xvalues, const auto& yvalues )
+    {
+        accumulate_counts( element_count, segment_numbers, cell_count, counts, [&] ( uint32_t element_index )
+        {
+            const auto column = static_cast<uint32_t>( std::clamp( ( xvalues[element_index] - xrange.lower ) * xscale, 0.0, upper ) );
+            const auto row = static_cast<uint32_t>( std::clamp( ( yvalues[element_index] - yrange.lower ) * yscale, 0.0, upper ) );
+            return row * _resolution + column;
+        } );
+    }, xfeature->values(), yfeature->values() );
 
     return counts;
+}
+Array<uint32_t> Histogram2D::compute_total_counts() const
+{
+    const auto& counts = this->counts();
+    const auto cell_count = size_t { _resolution } * _resolution;
+    const auto segment_count = cell_count ? counts.size() / cell_count : 0;
+
+    auto total_counts = Array<uint32_t> { cell_count, 0 };
+    utility::iterate_parallel( cell_count, [&] ( size_t cell_index )
+    {
+        auto count = uint32_t { 0 };
+        for( size_t segment_number = 0; segment_number < segment_count; ++segment_number )
+        {
+            count += counts[segment_number * cell_count + cell_index];
+        }
+        total_counts[cell_index] = count;
+    } );
+
+    return total_counts;
+}
+Array<float> Histogram2D::compute_densities() const
+{
+    const auto& total_counts = this->total_counts();
+    auto densities = Array<float> { total_counts.size(), 0.0f };
+
+    const auto maximum = total_counts.size() ? *std::max_element( total_counts.begin(), total_counts.end() ) : 0u;
+    if( maximum > 0 )
+    {
+        const auto normalization = _logarithmic ? 1.0 / std::log1p( static_cast<double>( maximum ) ) : 1.0 / maximum;
+        utility::iterate_parallel( total_counts.size(), [&] ( size_t cell_index )
+        {
+            const auto count = static_cast<double>( total_counts[cell_index] );
+            densities[cell_index] = static_cast<float>( ( _logarithmic ? std::log1p( count ) : count ) * normalization );
+        } );
+    }
+
+    return densities;
 }
\ No newline at end of file
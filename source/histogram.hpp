@@ -1,6 +1,9 @@
 #pragma once
 #include "utility.hpp"
 
+#include <array>
+#include <span>
+
 #include <qobject.h>
 #include <qsharedpointer.h>
 
@@ -13,6 +16,9 @@ class Histogram : public QObject
 {
     Q_OBJECT
 public:
+    // Counts are binned once at this resolution and re-aggregated for any bincount, it is divisible by all integers up to 12 and most common bincounts
+    static constexpr uint32_t base_bincount = 55440;
+
     Histogram( uint32_t bincount );
 
     QSharedPointer<const Feature> feature() const;
@@ -24,6 +30,9 @@ public:
     const Array<double>& edges() const;
     const Array<uint32_t>& counts() const;
 
+    // Whether every bin covers whole base bins, otherwise counts of straddling base bins are split proportionally
+    bool exact() const noexcept;
+
 signals:
     void feature_changed( QSharedPointer<const Feature> feature );
     void bincount_changed( uint32_t bincount );
@@ -31,13 +40,16 @@ signals:
     void counts_changed();
 
 private:
+    Range<double> compute_range() const;
     Array<double> compute_edges() const;
+    Array<uint32_t> compute_base_counts() const;
     Array<uint32_t> compute_counts() const;
 
     QWeakPointer<const Feature> _feature;
     uint32_t _bincount;
 
     Computed<Array<double>> _edges;
+    Computed<Array<uint32_t>> _base_counts;
     Computed<Array<uint32_t>> _counts;
 };
 
@@ -59,7 +71,9 @@ public:
     void update_bincount( uint32_t bincount );
 
     const Array<double>& edges() const;
-    const Array<Array<uint32_t>>& counts() const;
+    const Array<uint32_t>& counts() const;
+    std::span<const uint32_t> counts( uint32_t segment_number ) const;
+    bool exact() const noexcept;
 
 signals:
     void segmentation_changed( QSharedPointer<const Segmentation> segmentation );
@@ -69,13 +83,80 @@ signals:
     void counts_changed();
 
 private:
+    Range<double> compute_range() const;
     Array<double> compute_edges() const;
-    Array<Array<uint32_t>> compute_counts() const;
+    Array<uint32_t> compute_base_counts() const;
+    Array<uint16_t> compute_bin_indices() const;
+    Array<uint32_t> compute_counts() const;
+
+    void on_segment_numbers_changed();
 
     QWeakPointer<const Segmentation> _segmentation;
     QWeakPointer<const Feature> _feature;
     uint32_t _bincount;
 
     Computed<Array<double>> _edges;
-    Computed<Array<Array<uint32_t>>> _counts;
+    Computed<Array<uint32_t>> _base_counts;
+    Computed<Array<uint16_t>> _bin_indices;
+    Computed<Array<uint32_t>> _counts;
+};
+
+// ----- Histogram2D ----- //
+
+class Histogram2D : public QObject
+{
+    Q_OBJECT
+public:
+    Histogram2D( uint32_t resolution );
+
+    QSharedPointer<const Feature> xfeature() const;
+    void update_xfeature( QSharedPointer<const Feature> feature );
+
+    QSharedPointer<const Feature> yfeature() const;
+    void update_yfeature( QSharedPointer<const Feature> feature );
+
+    QSharedPointer<const Segmentation> segmentation() const;
+    void update_segmentation( QSharedPointer<const Segmentation> segmentation );
+
+    uint32_t resolution() const noexcept;
+    void update_resolution( uint32_t resolution );
+
+    bool logarithmic() const noexcept;
+    void update_logarithmic( bool logarithmic );
+
+    Range<double> xrange() const;
+    Range<double> yrange() const;
+    std::optional<uint32_t> cell_index( double x, double y ) const;
+
+    // Counts are laid out as segments x rows x columns, a single segment without segmentation
+    const Array<uint32_t>& counts() const;
+    std::span<const uint32_t> counts( uint32_t segment_number ) const;
+    const Array<uint32_t>& total_counts() const;
+    const Array<float>& densities() const;
+
+signals:
+    void xfeature_changed( QSharedPointer<const Feature> feature );
+    void yfeature_changed( QSharedPointer<const Feature> feature );
+    void segmentation_changed( QSharedPointer<const Segmentation> segmentation );
+    void resolution_changed( uint32_t resolution );
+    void logarithmic_changed( bool logarithmic );
+    void counts_changed();
+    void densities_changed();
+
+private:
+    Array<uint32_t> compute_counts() const;
+    Array<uint32_t> compute_total_counts() const;
+    Array<float> compute_densities() const;
+
+    QWeakPointer<const Feature> _xfeature;
+    QWeakPointer<const Feature> _yfeature;
+    std::array<QMetaObject::Connection, 2> _xfeature_connections;
+    std::array<QMetaObject::Connection, 2> _yfeature_connections;
+    QWeakPointer<const Segmentation> _segmentation;
+    uint32_t _resolution;
+    bool _logarithmic = true;
+
+    Computed<Array<uint32_t>> _counts;
+    Computed<Array<uint32_t>> _total_counts;
+    Computed<Array<float>> _densities;
 };
\ No newline at end of file
@@ -65,6 +65,7 @@ void HistogramViewer::update_feature( QSharedPointer<const Feature> feature )
 {
     _histogram.update_feature( feature );
     _segmentation_histogram.update_feature( feature );
+    _feature_residency.reset( feature ? &feature->computed_values() : nullptr );
 }
 
 uint32_t HistogramViewer::bincount() const noexcept
@@ -105,7 +106,7 @@ void HistogramViewer::paintEvent( QPaintEvent* event )
         uint32_t segment_number = 0;
     } hovered_object;
 
-    const auto render_histogram = [&] ( const Array<uint32_t>& counts, const QColor& color, uint32_t segment_number )
+    const auto render_histogram = [&] ( std::span<const uint32_t> counts, const QColor& color, uint32_t segment_number )
     {
         painter.setPen( QPen { QBrush { config::palette[600] }, 1.0 } );
         painter.setBrush( QBrush { color } );
@@ -129,20 +130,18 @@ void HistogramViewer::paintEvent( QPaintEvent* event )
             bins_bottom[bin] = top;
         }
     };
-    render_histogram( counts, config::palette[200], 0 );
+    render_histogram( std::span { counts.data(), counts.size() }, config::palette[200], 0 );
     const auto hovered_object_global = hovered_object;
     hovered_object = {};
 
     const auto segmentation = _database.segmentation();
-    const auto& segmentation_counts = _segmentation_histogram.counts();
 
     std::fill( bins_count.begin(), bins_count.end(), 0 );
     std::fill( bins_bottom.begin(), bins_bottom.end(), xaxis_screen );
 
     for( uint32_t segment_number = 1; segment_number < segmentation->segment_count(); ++segment_number )
     {
-        const auto& counts = segmentation_counts[segment_number];
-        render_histogram( counts, segmentation->segment( segment_number )->color().qcolor(), segment_number );
+        render_histogram( _segmentation_histogram.counts( segment_number ), segmentation->segment( segment_number )->color().qcolor(), segment_number );
     }
     const auto hovered_object_segmentation = hovered_object;
 
@@ -167,21 +166,21 @@ void HistogramViewer::paintEvent( QPaintEvent* event )
     {
         const auto percentage = counts[hovered_object_global.bin] / static_cast<double>( _database.dataset()->element_count() );
         labels_string += "Bin:";
-        values_string += QString::number( 100.0 * percentage, 'f', 1 ) + " % of dataset";
+        values_string += ( _histogram.exact() ? "" : "~" ) + QString::number( 100.0 * percentage, 'f', 1 ) + " % of dataset";
     }
 
     if( hovered_object_segmentation.rectangle.width() )
     {
         const auto segment = _database.segmentation()->segment( hovered_object_segmentation.segment_number );
-        const auto segment_count = segmentation_counts[hovered_object_segmentation.segment_number][hovered_object_segmentation.bin];
+        const auto segment_count = _segmentation_histogram.counts( hovered_object_segmentation.segment_number )[hovered_object_segmentation.bin];
         const auto percentage_segment = segment_count / static_cast<double>( segment->element_count() );
         const auto percentage_bin = segment_count / static_cast<double>( counts[hovered_object_segmentation.bin] );
 
         labels_string += "\nBin:";
-        values_string += '\n' + QString::number( 100.0 * percentage_segment, 'f', 1 ) + " % of segment";
+        values_string += ( _segmentation_histogram.exact() ? "\n" : "\n~" ) + QString::number( 100.0 * percentage_segment, 'f', 1 ) + " % of segment";
 
         labels_string += "\nSegment:";
-        values_string += '\n' + QString::number( 100.0 * percentage_bin, 'f', 1 ) + " % of bin";
+        values_string += ( _segmentation_histogram.exact() ? "\n" : "\n~" ) + QString::number( 100.0 * percentage_bin, 'f', 1 ) + " % of bin";
     }
 
     if( labels_string.size() || values_string.size() )
@@ -209,8 +208,7 @@ void HistogramViewer::paintEvent( QPaintEvent* event )
     {
         if( const auto feature = _histogram.feature() )
         {
-            const auto& feature_values = feature->values();
-            const auto xscreen = this->world_to_screen_x( feature_values[*element_index] );
+            const auto xscreen = this->world_to_screen_x( feature->value( *element_index ) );
             painter.setPen( QPen { QColor { config::palette[500] }, 1.0, Qt::DashLine } );
             painter.drawLine(
                 QPointF { xscreen, static_cast<double>( content_rectangle.bottom() ) },
@@ -323,7 +321,7 @@ void HistogramViewer::export_histograms() const
         }
         stream << '\n';
 
-        const auto write_histogram = [&stream] ( const QString& identifier, uint32_t total_element_count, const Array<uint32_t>& counts )
+        const auto write_histogram = [&stream] ( const QString& identifier, uint32_t total_element_count, std::span<const uint32_t> counts )
         {
             stream << identifier << "," << total_element_count;
             for( const auto value : counts ) stream << ',' << value;
@@ -331,15 +329,13 @@ void HistogramViewer::export_histograms() const
         };
 
         const auto segmentation = _database.segmentation();
-        const auto counts = _histogram.counts();
-        write_histogram( "Dataset", segmentation->element_count(), counts );
-
-        const auto& segmentation_counts = _segmentation_histogram.counts();
+        const auto& counts = _histogram.counts();
+        write_histogram( "Dataset", segmentation->element_count(), std::span { counts.data(), counts.size() } );
 
         for( uint32_t segment_number = 1; segment_number < segmentation->segment_count(); ++segment_number )
         {
             const auto segment = _database.segmentation()->segment( segment_number );
-            write_histogram( segment->identifier(), segment->element_count(), segmentation_counts[segment_number] );
+            write_histogram( segment->identifier(), segment->element_count(), _segmentation_histogram.counts( segment_number ) );
         }
     }
 }
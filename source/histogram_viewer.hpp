@@ -27,6 +27,7 @@ private:
 	Database& _database;
 	Histogram _histogram { 20 };
 	StackedHistogram _segmentation_histogram { 20 };
+	CacheResidency _feature_residency;
 
 	QPointF _cursor_position;
 };
\ No newline at end of file
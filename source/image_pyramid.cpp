@@ -0,0 +1,187 @@
+#include "image_pyramid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <qpainter.h>
+
+// ----- ImagePyramid ----- //
+
+void ImagePyramid::draw( QPainter& painter, const std::function<const QImage&()>& source, const QRectF& target, const QRectF& visible )
+{
+    const auto visible_target = target.intersected( visible );
+    if( visible_target.isEmpty() )
+    {
+        return;
+    }
+
+    // The source is only resolved when tiles are missing, or when its size is not yet known
+    const QImage* source_image = nullptr;
+    const auto resolve_source = [&] () -> const QImage&
+    {
+        if( !source_image ) source_image = &source();
+        return *source_image;
+    };
+
+    if( _size.isEmpty() )
+    {
+        _size = resolve_source().size();
+        _level_count = 1;
+        while( std::max( _size.width(), _size.height() ) > ( tile_size << ( _level_count - 1 ) ) )
+        {
+            ++_level_count;
+        }
+    }
+    if( _size.isEmpty() )
+    {
+        return;
+    }
+
+    // Finest level that still has at least one image pixel per screen pixel
+    const auto device_pixel_ratio = painter.device() ? painter.device()->devicePixelRatioF() : 1.0;
+    const auto pixels_per_screen_pixel = _size.width() / ( target.width() * device_pixel_ratio );
+    const auto level = static_cast<uint32_t>( std::clamp( std::floor( std::log2( std::max( pixels_per_screen_pixel, 1.0 ) ) ), 0.0, static_cast<double>( _level_count - 1 ) ) );
+    const auto level_tile_size = static_cast<double>( tile_size << level );
+
+    const auto scale_x = target.width() / _size.width();
+    const auto scale_y = target.height() / _size.height();
+
+    const auto first_x = static_cast<uint32_t>( std::max( 0.0, ( visible_target.left() - target.left() ) / scale_x / level_tile_size ) );
+    const auto first_y = static_cast<uint32_t>( std::max( 0.0, ( visible_target.top() - target.top() ) / scale_y / level_tile_size ) );
+    const auto last_x = static_cast<uint32_t>( std::ceil( ( visible_target.right() - target.left() ) / scale_x / level_tile_size ) );
+    const auto last_y = static_cast<uint32_t>( std::ceil( ( visible_target.bottom() - target.top() ) / scale_y / level_tile_size ) );
+
+    this->touch();
+
+    for( auto y = first_y; y < last_y; ++y )
+    {
+        for( auto x = first_x; x < last_x; ++x )
+        {
+            const auto source_left = x * level_tile_size;
+            const auto source_top = y * level_tile_size;
+            if( source_left >= _size.width() || source_top >= _size.height() )
+            {
+                continue;
+            }
+
+            const auto source_right = std::min( source_left + level_tile_size, static_cast<double>( _size.width() ) );
+            const auto source_bottom = std::min( source_top + level_tile_size, static_cast<double>( _size.height() ) );
+            const auto tile_rectangle = QRectF {
+                QPointF { target.left() + source_left * scale_x, target.top() + source_top * scale_y },
+                QPointF { target.left() + source_right * scale_x, target.top() + source_bottom * scale_y }
+            };
+
+            if( level == 0 )
+            {
+                painter.drawImage( tile_rectangle, resolve_source(), QRectF { QPointF { source_left, source_top }, QPointF { source_right, source_bottom } } );
+            }
+            else if( const auto key = ImagePyramid::key( level, x, y ); _tiles.contains( key ) )
+            {
+                painter.drawImage( tile_rectangle, _tiles.at( key ) );
+            }
+            else
+            {
+                painter.drawImage( tile_rectangle, this->tile( level, x, y, resolve_source() ) );
+            }
+        }
+    }
+}
+
+void ImagePyramid::invalidate()
+{
+    this->uncache();
+    _tiles.clear();
+    _bytes = 0;
+    _size = QSize {};
+    _level_count = 0;
+}
+void ImagePyramid::invalidate( const QRect& region )
+{
+    if( region.isEmpty() )
+    {
+        return;
+    }
+
+    for( uint32_t level = 1; level < _level_count; ++level )
+    {
+        const auto level_tile_size = tile_size << level;
+        for( auto y = region.top() / level_tile_size; y <= region.bottom() / level_tile_size; ++y )
+        {
+            for( auto x = region.left() / level_tile_size; x <= region.right() / level_tile_size; ++x )
+            {
+                if( const auto iterator = _tiles.find( ImagePyramid::key( level, x, y ) ); iterator != _tiles.end() )
+                {
+                    _bytes -= static_cast<size_t>( iterator->second.sizeInBytes() );
+                    _tiles.erase( iterator );
+                }
+            }
+        }
+    }
+
+    if( _tiles.empty() )
+    {
+        this->uncache();
+    }
+    else
+    {
+        this->cache( _bytes, true );
+    }
+}
+
+uint64_t ImagePyramid::key( uint32_t level, uint32_t x, uint32_t y ) noexcept
+{
+    return ( uint64_t { level } << 48 ) | ( uint64_t { y } << 24 ) | x;
+}
+
+void ImagePyramid::evict() const noexcept
+{
+    _tiles.clear();
+    _bytes = 0;
+}
+
+const QImage& ImagePyramid::tile( uint32_t level, uint32_t x, uint32_t y, const QImage& source )
+{
+    const auto key = ImagePyramid::key( level, x, y );
+    if( const auto iterator = _tiles.find( key ); iterator != _tiles.end() )
+    {
+        return iterator->second;
+    }
+
+    // Children are composed at their own resolution and averaged down by a factor of two, level 0 children are read from the source
+    const auto child_level_size = QSize {
+        ( _size.width() + ( 1 << ( level - 1 ) ) - 1 ) >> ( level - 1 ),
+        ( _size.height() + ( 1 << ( level - 1 ) ) - 1 ) >> ( level - 1 )
+    };
+    const auto children_rectangle = QRect { static_cast<int>( 2 * x ) * tile_size, static_cast<int>( 2 * y ) * tile_size, 2 * tile_size, 2 * tile_size }.intersected( QRect { QPoint {}, child_level_size } );
+
+    auto children = QImage {};
+    if( level == 1 )
+    {
+        children = source.copy( children_rectangle ).convertToFormat( QImage::Format_ARGB32_Premultiplied );
+    }
+    else
+    {
+        children = QImage { children_rectangle.size(), QImage::Format_ARGB32_Premultiplied };
+        children.fill( Qt::transparent );
+
+        auto painter = QPainter { &children };
+        painter.setCompositionMode( QPainter::CompositionMode_Source );
+        for( uint32_t child_y = 0; child_y < 2; ++child_y )
+        {
+            for( uint32_t child_x = 0; child_x < 2; ++child_x )
+            {
+                const auto offset = QPoint { static_cast<int>( child_x ) * tile_size, static_cast<int>( child_y ) * tile_size };
+                if( children_rectangle.contains( children_rectangle.topLeft() + offset ) )
+                {
+                    painter.drawImage( offset, this->tile( level - 1, 2 * x + child_x, 2 * y + child_y, source ) );
+                }
+            }
+        }
+    }
+    auto tile = children.scaled( ( children.width() + 1 ) / 2, ( children.height() + 1 ) / 2, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+
+    _bytes += static_cast<size_t>( tile.sizeInBytes() );
+    this->cache( _bytes, true );
+
+    return _tiles[key] = std::move( tile );
+}
\ No newline at end of file
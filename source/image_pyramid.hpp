@@ -0,0 +1,37 @@
+#pragma once
+#include "utility.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+#include <qimage.h>
+
+class QPainter;
+
+// ----- ImagePyramid ----- //
+
+// Lazily built power-of-two pyramid of premultiplied tiles, level 0 is drawn from the source and coarser tiles downsample their four children
+// The tiles are registered with the cache manager as a whole and dropped on eviction, they are rebuilt from the source on demand
+class ImagePyramid : public ComputedObject
+{
+public:
+    static constexpr auto tile_size = 256;
+
+    void draw( QPainter& painter, const std::function<const QImage&()>& source, const QRectF& target, const QRectF& visible );
+
+    void invalidate() override;
+    void invalidate( const QRect& region );
+
+private:
+    static uint64_t key( uint32_t level, uint32_t x, uint32_t y ) noexcept;
+
+    void evict() const noexcept override;
+
+    const QImage& tile( uint32_t level, uint32_t x, uint32_t y, const QImage& source );
+
+    QSize _size;
+    uint32_t _level_count = 0;
+    mutable std::unordered_map<uint64_t, QImage> _tiles;
+    mutable size_t _bytes = 0;
+};
\ No newline at end of file
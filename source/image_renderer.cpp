@@ -0,0 +1,246 @@
+#include "image_renderer.hpp"
+
+#include "colormap.hpp"
+#include "dataset.hpp"
+#include "dataset_importer.hpp"
+#include "feature.hpp"
+#include "filestream.hpp"
+#include "segmentation.hpp"
+
+#include <qdir.h>
+#include <qimagewriter.h>
+#include <qregularexpression.h>
+
+// ----- ImageRenderer ----- //
+
+ImageRenderer::ImageRenderer( vec2<uint32_t> dimensions ) : _dimensions { dimensions }
+{}
+
+void ImageRenderer::add_layer( QSharedPointer<const Colormap> colormap, double opacity )
+{
+    _layers.push_back( Layer { std::move( colormap ), opacity } );
+}
+void ImageRenderer::add_layer( QSharedPointer<const Segmentation> segmentation, double opacity )
+{
+    _layers.push_back( Layer { std::move( segmentation ), opacity } );
+}
+void ImageRenderer::add_layer( const QImage& image, double opacity )
+{
+    _layers.push_back( Layer { image.convertToFormat( QImage::Format_RGBA8888 ), opacity } );
+}
+
+QImage ImageRenderer::render( double scaling ) const
+{
+    const auto width = std::max( static_cast<int>( std::lround( _dimensions.x * scaling ) ), 1 );
+    const auto height = std::max( static_cast<int>( std::lround( _dimensions.y * scaling ) ), 1 );
+    const auto element_count = size_t { _dimensions.x } * _dimensions.y;
+
+    // Nearest source pixel of every target column and row
+    auto source_columns = std::vector<uint32_t>( width );
+    for( int x = 0; x < width; ++x )
+    {
+        source_columns[x] = std::min( static_cast<uint32_t>( ( x + 0.5 ) / width * _dimensions.x ), _dimensions.x - 1 );
+    }
+    auto source_rows = std::vector<uint32_t>( height );
+    for( int y = 0; y < height; ++y )
+    {
+        source_rows[y] = std::min( static_cast<uint32_t>( ( y + 0.5 ) / height * _dimensions.y ), _dimensions.y - 1 );
+    }
+
+    // Lazily computed layer data is resolved up front, so the row loop only reads plain arrays
+    struct ResolvedLayer
+    {
+        const Array<vec4<float>>* colors = nullptr;
+        const Array<uint32_t>* segment_numbers = nullptr;
+        std::vector<vec4<float>> palette;
+        const QImage* image = nullptr;
+        float opacity = 1.0f;
+    };
+
+    auto resolved_layers = std::vector<ResolvedLayer> {};
+    for( const auto& layer : _layers )
+    {
+        auto resolved_layer = ResolvedLayer { .opacity = static_cast<float>( layer.opacity ) };
+        if( const auto colormap = std::get_if<QSharedPointer<const Colormap>>( &layer.source ) )
+        {
+            if( !*colormap || ( *colormap )->colors().size() != element_count )
+            {
+                Console::warning( "ImageRenderer::render: Colormap does not match the image dimensions" );
+                continue;
+            }
+            resolved_layer.colors = &( *colormap )->colors();
+        }
+        else if( const auto segmentation = std::get_if<QSharedPointer<const Segmentation>>( &layer.source ) )
+        {
+            if( !*segmentation || ( *segmentation )->element_count() != element_count )
+            {
+                Console::warning( "ImageRenderer::render: Segmentation does not match the image dimensions" );
+                continue;
+            }
+            resolved_layer.segment_numbers = &( *segmentation )->segment_numbers();
+            for( const auto color : ( *segmentation )->palette() )
+            {
+                resolved_layer.palette.push_back( vec4<float> { qRed( color ) / 255.0f, qGreen( color ) / 255.0f, qBlue( color ) / 255.0f, qAlpha( color ) / 255.0f } );
+            }
+        }
+        else if( const auto image = std::get_if<QImage>( &layer.source ); image && !image->isNull() )
+        {
+            resolved_layer.image = image;
+        }
+        else continue;
+
+        resolved_layers.push_back( std::move( resolved_layer ) );
+    }
+
+    auto image = QImage { width, height, QImage::Format_RGBA8888_Premultiplied };
+    const auto bits = image.bits();
+    const auto bytes_per_line = static_cast<size_t>( image.bytesPerLine() );
+    utility::iterate_parallel( height, [&] ( int y )
+    {
+        const auto source_y = source_rows[y];
+        const auto scanline = bits + y * bytes_per_line;
+        for( int x = 0; x < width; ++x )
+        {
+            const auto source_x = source_columns[x];
+            const auto element_index = size_t { source_y } * _dimensions.x + source_x;
+
+            // Layers are composited back to front with the over operator on premultiplied colors
+            auto composite = vec4<float> { 0.0f, 0.0f, 0.0f, 0.0f };
+            for( const auto& layer : resolved_layers )
+            {
+                auto color = vec4<float> {};
+                if( layer.colors )
+                {
+                    color = ( *layer.colors )[element_index];
+                }
+                else if( layer.segment_numbers )
+                {
+                    color = layer.palette[( *layer.segment_numbers )[element_index]];
+                }
+                else
+                {
+                    const auto image_x = static_cast<int>( size_t { source_x } * layer.image->width() / _dimensions.x );
+                    const auto image_y = static_cast<int>( size_t { source_y } * layer.image->height() / _dimensions.y );
+                    const auto pixel = layer.image->constScanLine( image_y ) + 4 * image_x;
+                    color = vec4<float> { pixel[0] / 255.0f, pixel[1] / 255.0f, pixel[2] / 255.0f, pixel[3] / 255.0f };
+                }
+
+                const auto alpha = color.a * layer.opacity;
+                composite.r = color.r * alpha + composite.r * ( 1.0f - alpha );
+                composite.g = color.g * alpha + composite.g * ( 1.0f - alpha );
+                composite.b = color.b * alpha + composite.b * ( 1.0f - alpha );
+                composite.a = alpha + composite.a * ( 1.0f - alpha );
+            }
+
+            const auto pixel = scanline + 4 * x;
+            pixel[0] = static_cast<uchar>( std::clamp( composite.r, 0.0f, 1.0f ) * 255.0f + 0.5f );
+            pixel[1] = static_cast<uchar>( std::clamp( composite.g, 0.0f, 1.0f ) * 255.0f + 0.5f );
+            pixel[2] = static_cast<uchar>( std::clamp( composite.b, 0.0f, 1.0f ) * 255.0f + 0.5f );
+            pixel[3] = static_cast<uchar>( std::clamp( composite.a, 0.0f, 1.0f ) * 255.0f + 0.5f );
+        }
+    } );
+
+    return image;
+}
+
+bool ImageRenderer::save( const QImage& image, const QString& filepath )
+{
+    auto writer = QImageWriter { filepath };
+    if( !writer.write( image ) )
+    {
+        Console::error( std::format( "Failed to write image {}: {}", filepath.toStdString(), writer.errorString().toStdString() ) );
+        return false;
+    }
+    return true;
+}
+
+int ImageRenderer::execute_batch( const QStringList& arguments )
+{
+    // <executable> --render <dataset> <output directory> [--segmentation <file.mia>] [--colormap <name>] [--scaling <factor>] [--opacity <segmentation opacity>] [--format <png|tiff>]
+    if( arguments.size() < 4 )
+    {
+        Console::error( "Usage: --render <dataset> <output directory> [--segmentation <file.mia>] [--colormap <name>] [--scaling <factor>] [--opacity <segmentation opacity>] [--format <png|tiff>]" );
+        return 1;
+    }
+
+    auto segmentation_filepath = QString {};
+    auto colormap_name = QString { "viridis" };
+    auto scaling = 1.0;
+    auto segmentation_opacity = 0.5;
+    auto format = QString { "png" };
+    for( qsizetype i = 4; i + 1 < arguments.size(); i += 2 )
+    {
+        const auto& option = arguments[i];
+        const auto& value = arguments[i + 1];
+        if( option == "--segmentation" ) segmentation_filepath = value;
+        else if( option == "--colormap" ) colormap_name = value;
+        else if( option == "--scaling" ) scaling = value.toDouble();
+        else if( option == "--opacity" ) segmentation_opacity = value.toDouble();
+        else if( option == "--format" ) format = value;
+        else Console::warning( std::format( "Unknown render option {}", option.toStdString() ) );
+    }
+
+    const auto colormap_template = std::find_if( ColormapTemplate::registry.begin(), ColormapTemplate::registry.end(), [&] ( const auto& entry )
+    {
+        return colormap_name.compare( entry.first, Qt::CaseInsensitive ) == 0;
+    } );
+    if( colormap_template == ColormapTemplate::registry.end() || scaling <= 0.0 )
+    {
+        Console::error( "Invalid colormap or scaling" );
+        return 1;
+    }
+
+    DatasetImporter::interactive = false;
+    const auto dataset = DatasetImporter::from_file( arguments[2].toStdWString() );
+    const auto spatial_metadata = dataset ? dataset->spatial_metadata() : nullptr;
+    if( !spatial_metadata )
+    {
+        Console::error( "Failed to import dataset, or dataset has no spatial metadata" );
+        return 1;
+    }
+
+    auto segmentation = QSharedPointer<Segmentation> {};
+    if( !segmentation_filepath.isEmpty() )
+    {
+        segmentation = QSharedPointer<Segmentation>::create( dataset->element_count() );
+        auto stream = MIAFileStream { segmentation_filepath.toStdWString(), std::ios::in };
+        if( !segmentation->deserialize( stream ) )
+        {
+            Console::error( "Failed to import segmentation" );
+            return 1;
+        }
+    }
+
+    const auto output_directory = QDir { arguments[3] };
+    if( !output_directory.mkpath( "." ) )
+    {
+        Console::error( "Failed to create output directory" );
+        return 1;
+    }
+
+    // Every channel gets its own feature and colormap, so only one channel is held in memory at a time
+    auto failure_count = 0;
+    for( uint32_t channel_index = 0; channel_index < dataset->channel_count(); ++channel_index )
+    {
+        const auto feature = QSharedPointer<DatasetChannelsFeature>::create( dataset, Range<uint32_t> { channel_index, channel_index }, DatasetChannelsFeature::Reduction::eAccumulate, DatasetChannelsFeature::BaselineCorrection::eNone );
+        const auto colormap = QSharedPointer<Colormap1D>::create( colormap_template->second.clone() );
+        colormap->update_feature( feature );
+
+        auto renderer = ImageRenderer { spatial_metadata->dimensions };
+        renderer.add_layer( colormap, 1.0 );
+        if( segmentation )
+        {
+            renderer.add_layer( segmentation, segmentation_opacity );
+        }
+
+        const auto identifier = QString { dataset->channel_identifier( channel_index ) }.replace( QRegularExpression { "[^A-Za-z0-9._-]" }, "_" );
+        const auto filename = QString::number( channel_index ).rightJustified( 4, '0' ) + "_" + identifier + "." + format;
+        if( !ImageRenderer::save( renderer.render( scaling ), output_directory.filePath( filename ) ) )
+        {
+            ++failure_count;
+        }
+    }
+
+    Console::info( std::format( "Rendered {} of {} channels", dataset->channel_count() - failure_count, dataset->channel_count() ) );
+    return failure_count == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+#include "utility.hpp"
+
+#include <variant>
+
+#include <qimage.h>
+#include <qsharedpointer.h>
+#include <qstringlist.h>
+
+class Colormap;
+class Segmentation;
+
+// ----- ImageRenderer ----- //
+
+// Composes image layers on the CPU, so images can be rendered and written without a widget, display or GPU
+class ImageRenderer
+{
+public:
+    ImageRenderer( vec2<uint32_t> dimensions );
+
+    void add_layer( QSharedPointer<const Colormap> colormap, double opacity );
+    void add_layer( QSharedPointer<const Segmentation> segmentation, double opacity );
+    void add_layer( const QImage& image, double opacity );
+
+    // Layers are sampled at the nearest pixel, the result has the dimensions multiplied by the scaling
+    QImage render( double scaling = 1.0 ) const;
+
+    // The format is taken from the file suffix, e.g. png or tiff
+    static bool save( const QImage& image, const QString& filepath );
+
+    // Renders every channel of a dataset into an output directory, used for the --render command line mode
+    static int execute_batch( const QStringList& arguments );
+
+private:
+    struct Layer
+    {
+        std::variant<QSharedPointer<const Colormap>, QSharedPointer<const Segmentation>, QImage> source;
+        double opacity;
+    };
+
+    vec2<uint32_t> _dimensions;
+    std::vector<Layer> _layers;
+};
\ No newline at end of file
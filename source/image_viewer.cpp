@@ -1,10 +1,14 @@
 #include "image_viewer.hpp"
 
 #include "colormap.hpp"
+#include "configuration.hpp"
+#include "connectivity.hpp"
 #include "database.hpp"
 #include "dataset.hpp"
 #include "feature.hpp"
+#include "image_renderer.hpp"
 #include "python.hpp"
+#include "rasterization.hpp"
 #include "segmentation.hpp"
 
 #include <qactiongroup.h>
@@ -19,6 +23,29 @@
 #include <qmimedata.h>
 #include <qpainter.h>
 
+namespace
+{
+    // Converts straight alpha float colors to the premultiplied 8-bit format QPainter draws without conversion
+    QImage convert_colors( const Array<vec4<float>>& colors, vec2<uint32_t> dimensions )
+    {
+        auto image = QImage { static_cast<int>( dimensions.x ), static_cast<int>( dimensions.y ), QImage::Format_ARGB32_Premultiplied };
+        const auto bits = image.bits();
+        const auto bytes_per_line = static_cast<size_t>( image.bytesPerLine() );
+        utility::iterate_parallel( dimensions.y, [&] ( uint32_t y )
+        {
+            auto scanline = reinterpret_cast<QRgb*>( bits + y * bytes_per_line );
+            const auto row = colors.data() + size_t { y } * dimensions.x;
+            for( uint32_t x = 0; x < dimensions.x; ++x )
+            {
+                const auto alpha = std::clamp( row[x].a, 0.0f, 1.0f );
+                const auto channel = [alpha] ( float value ) { return static_cast<int>( std::clamp( value, 0.0f, 1.0f ) * alpha * 255.0f + 0.5f ); };
+                scanline[x] = qRgba( channel( row[x].r ), channel( row[x].g ), channel( row[x].b ), static_cast<int>( alpha * 255.0f + 0.5f ) );
+            }
+        } );
+        return image;
+    }
+}
+
 // ----- ImageViewer ----- //
 
 ImageViewer::ImageViewer( Database& database ) : QWidget {}, _database { database }
@@ -27,11 +54,44 @@ ImageViewer::ImageViewer( Database& database ) : QWidget {}, _database { databas
     this->setMouseTracking( true );
 
     const auto segmentation = _database.segmentation();
-    QObject::connect( segmentation.get(), &Segmentation::element_colors_changed, this, qOverload<>( &QWidget::update ) );
+    _segmentation_image.initialize( std::bind( &ImageViewer::compute_segmentation_image, this ) );
+    QObject::connect( segmentation.get(), &Segmentation::segment_numbers_edited, this, &ImageViewer::update_segmentation_image );
+    QObject::connect( segmentation.get(), &Segmentation::segment_color_changed, this, &ImageViewer::update_segmentation_palette );
+    QObject::connect( segmentation.get(), &Segmentation::segment_count_changed, this, [this]
+    {
+        _segmentation_pyramid.invalidate();
+        _segmentation_image.invalidate();
+        this->update();
+    } );
+    _segmentation_residency.reset( &_segmentation_image );
+
     QObject::connect( &_database, &Database::highlighted_element_index_changed, this, qOverload<>( &QWidget::update ) );
 
+    _colormap_image.initialize( std::bind( &ImageViewer::compute_colormap_image, this ) );
+    QObject::connect( &_colormap_image, &ComputedObject::changed, this, [this]
+    {
+        _colormap_pyramid.invalidate();
+        _colormap_preview.invalidate();
+        if( _refine_timer.isActive() )
+        {
+            _refine_timer.start();
+        }
+        this->update();
+    } );
+
+    _colormap_preview.initialize( std::bind( &ImageViewer::compute_colormap_preview, this ) );
+    _refine_timer.setSingleShot( true );
+    _refine_timer.setInterval( config::progressive_refine_delay );
+    QObject::connect( &_refine_timer, &QTimer::timeout, this, &ImageViewer::refine_colormap_image );
+
     const auto colormap_embedding = _database.colormap_embedding();
-    QObject::connect( colormap_embedding.get(), &ColormapEmbedding::colors_changed, this, qOverload<>( &QWidget::update ) );
+    _false_coloring_image.initialize( std::bind( &ImageViewer::compute_false_coloring_image, this ) );
+    QObject::connect( colormap_embedding.get(), &ColormapEmbedding::colors_changed, &_false_coloring_image, &ComputedObject::invalidate );
+    QObject::connect( &_false_coloring_image, &ComputedObject::changed, this, [this]
+    {
+        _false_coloring_pyramid.invalidate();
+        this->update();
+    } );
 }
 
 void ImageViewer::update_colormap( QSharedPointer<Colormap> colormap )
@@ -40,13 +100,14 @@ void ImageViewer::update_colormap( QSharedPointer<Colormap> colormap )
     {
         if( auto colormap = _colormap.lock() )
         {
-            QObject::disconnect( colormap.get(), &Colormap::colors_changed, this, qOverload<>( &QWidget::update ) );
+            QObject::disconnect( colormap.get(), &Colormap::colors_changed, &_colormap_image, &ComputedObject::invalidate );
         }
         if( _colormap = colormap )
         {
-            QObject::connect( colormap.get(), &Colormap::colors_changed, this, qOverload<>( &QWidget::update ) );
+            QObject::connect( colormap.get(), &Colormap::colors_changed, &_colormap_image, &ComputedObject::invalidate );
         }
-        this->update();
+        _colormap_residency.reset( colormap ? &_colormap_image : nullptr );
+        _colormap_image.invalidate();
     }
 }
 
@@ -67,40 +128,44 @@ void ImageViewer::paintEvent( QPaintEvent* event )
     const auto dataset = _database.dataset();
     const auto segmentation = _database.segmentation();
 
-    // Render image
+    // Render image, only tiles of the pyramid level matching the zoom that intersect the widget are drawn
+    const auto visible_rectangle = QRectF { event->rect() };
     if( const auto colormap = _colormap.lock() )
     {
-        if( const auto& colors = colormap->colors(); colors.size() )
+        painter.setOpacity( _image_opacity );
+        if( _colormap_image.present() || colormap->colors_present() || colormap->element_count() <= config::progressive_preview_element_count )
         {
-            const auto dimensions = dataset->spatial_metadata()->dimensions;
-            const auto image = QImage { reinterpret_cast<const uchar*>( colors.data() ), static_cast<int>( dimensions.x ), static_cast<int>( dimensions.y ), QImage::Format_RGBA32FPx4 };
-            painter.setOpacity( _image_opacity );
-            painter.drawImage( _image_rectangle, image );
-            painter.setOpacity( 1.0 );
+            _colormap_pyramid.draw( painter, [this] () -> const QImage& { return *_colormap_image; }, _image_rectangle, visible_rectangle );
+        }
+        else
+        {
+            // Large colormaps that are not computed yet show an upsampled preview until the refinement runs
+            if( const auto& preview = *_colormap_preview; !preview.isNull() )
+            {
+                painter.setRenderHint( QPainter::SmoothPixmapTransform );
+                painter.drawImage( _image_rectangle, preview );
+                painter.setRenderHint( QPainter::SmoothPixmapTransform, false );
+            }
+            if( !_refine_timer.isActive() )
+            {
+                _refine_timer.start();
+            }
         }
+        painter.setOpacity( 1.0 );
     }
 
     if( _coloring == ColoringMode::eSegmentation )
     {
         // Render segmentation colors
-        const auto& segmentation_colors = segmentation->element_colors();
-        const auto dimensions = dataset->spatial_metadata()->dimensions;
-        const auto image = QImage { reinterpret_cast<const uchar*>( segmentation_colors.data() ), static_cast<int>( dimensions.x ), static_cast<int>( dimensions.y ), QImage::Format_RGBA32FPx4 };
         painter.setOpacity( _segmentation_opacity );
-        painter.drawImage( _image_rectangle, image );
+        _segmentation_pyramid.draw( painter, [this] () -> const QImage& { return *_segmentation_image; }, _image_rectangle, visible_rectangle );
         painter.setOpacity( 1.0 );
     }
     else if( _coloring == ColoringMode::eFalseColoring )
     {
-        if( const auto colormap = _database.colormap_embedding() )
-        {
-            const auto& colors = colormap->colors();
-            const auto dimensions = dataset->spatial_metadata()->dimensions;
-            const auto image = QImage { reinterpret_cast<const uchar*>( colors.data() ), static_cast<int>( dimensions.x ), static_cast<int>( dimensions.y ), QImage::Format_RGBA32FPx4 };
-            painter.setOpacity( _segmentation_opacity );
-            painter.drawImage( _image_rectangle, image );
-            painter.setOpacity( 1.0 );
-        }
+        painter.setOpacity( _segmentation_opacity );
+        _false_coloring_pyramid.draw( painter, [this] () -> const QImage& { return *_false_coloring_image; }, _image_rectangle, visible_rectangle );
+        painter.setOpacity( 1.0 );
     }
 
     // Render overlay image
@@ -165,7 +230,23 @@ void ImageViewer::paintEvent( QPaintEvent* event )
 
         painter.setPen( QPen { stroke_color, 2.0 } );
         painter.setBrush( brush_color );
-        painter.drawPolygon( _selection_polygon );
+        if( _selection_tool == SelectionTool::eRectangle )
+        {
+            painter.drawRect( QRectF { _selection_polygon.front(), _selection_polygon.back() }.normalized() );
+        }
+        else if( _selection_tool == SelectionTool::eLasso )
+        {
+            painter.drawPolygon( _selection_polygon );
+        }
+    }
+
+    // Render brush outline, painted elements show up in the segmentation layer directly
+    if( _selection_tool == SelectionTool::eBrush && _image_rectangle.contains( _cursor_position ) )
+    {
+        const auto radius = _brush_radius * _image_rectangle.width() / dataset->spatial_metadata()->width;
+        painter.setPen( QPen { QColor { 200, 200, 200 }, 1.0 } );
+        painter.setBrush( Qt::NoBrush );
+        painter.drawEllipse( _cursor_position, radius, radius );
     }
 
     // Render highlighted element information
@@ -189,10 +270,9 @@ void ImageViewer::paintEvent( QPaintEvent* event )
             {
                 if( auto feature = colormap_1d->feature() )
                 {
-                    const auto& feature_values = feature->values();
-                    if( feature_values.size() > *element_index )
+                    if( feature->element_count() > *element_index )
                     {
-                        const auto value = feature_values[*element_index];
+                        const auto value = feature->value( *element_index );
                         labels_string += QString { "\nvalue: " };
                         values_string += '\n' + QString::number( value, 'f', std::min( 5, utility::compute_precision( value ) ) );
                     }
@@ -289,6 +369,19 @@ void ImageViewer::mousePressEvent( QMouseEvent* event )
         _selection_polygon.append( event->position() );
         _selection_mode = InteractionMode::eShrinkSegment;
     }
+
+    if( _selection_tool == SelectionTool::eBrush && _selection_mode != InteractionMode::eNone )
+    {
+        // Right clicks still open the context menu, so nothing is painted before the mouse moves or is released
+        // A stroke is undone as a whole and reported to other views once, the group is closed when the mouse is released
+        _database.segmentation()->begin_history_group();
+        _brush_stroke = QPolygonF { this->screen_to_image( event->position() ) };
+        _database.update_highlighted_element_index( std::nullopt );
+        if( event->button() == Qt::LeftButton )
+        {
+            this->apply_brush_stroke();
+        }
+    }
 }
 void ImageViewer::mouseReleaseEvent( QMouseEvent* event )
 {
@@ -308,6 +401,16 @@ void ImageViewer::mouseReleaseEvent( QMouseEvent* event )
                 auto context_menu = QMenu {};
 
                 _database.populate_segmentation_menu( context_menu );
+
+                auto grow_region_menu = context_menu.addMenu( "Grow Region" );
+                const auto seed_element_index = _database.dataset()->spatial_metadata()->element_index( this->screen_to_pixel( event->position() ) );
+                for( const auto threshold : { 1, 2, 5, 10, 20, 50 } )
+                {
+                    grow_region_menu->addAction( QString::number( threshold ) + " % Distance", [this, seed_element_index, threshold]
+                    {
+                        connectivity::grow_region( *_database.dataset(), *_database.segmentation(), seed_element_index, _database.active_segment()->number(), threshold / 100.0 );
+                    } );
+                }
                 context_menu.addSeparator();
 
                 auto coloring_menu = context_menu.addMenu( "Coloring" );
@@ -374,6 +477,58 @@ void ImageViewer::mouseReleaseEvent( QMouseEvent* event )
                     segmentation_opacity_action_group->addAction( action );
                 }
 
+                auto selection_tool_menu = context_menu.addMenu( "Selection Tool" );
+                auto selection_tool_action_group = new QActionGroup { selection_tool_menu };
+                selection_tool_action_group->setExclusive( true );
+
+                const auto selection_tool_options = std::vector<std::pair<const char*, SelectionTool>> {
+                    { "Lasso", SelectionTool::eLasso },
+                    { "Rectangle", SelectionTool::eRectangle },
+                    { "Brush", SelectionTool::eBrush },
+                };
+
+                for( const auto [label, selection_tool] : selection_tool_options )
+                {
+                    const auto action = selection_tool_menu->addAction( label, [this, selection_tool] { _selection_tool = selection_tool; } );
+                    action->setCheckable( true );
+                    action->setChecked( _selection_tool == selection_tool );
+                    selection_tool_action_group->addAction( action );
+                }
+
+                auto brush_radius_menu = context_menu.addMenu( "Brush Radius" );
+                auto brush_radius_action_group = new QActionGroup { brush_radius_menu };
+                brush_radius_action_group->setExclusive( true );
+
+                for( const auto brush_radius : { 1.0, 2.0, 5.0, 10.0, 20.0, 50.0 } )
+                {
+                    const auto action = brush_radius_menu->addAction( QString::number( brush_radius ) + " px", [this, brush_radius] { _brush_radius = brush_radius; } );
+                    action->setCheckable( true );
+                    action->setChecked( _brush_radius == brush_radius );
+                    brush_radius_action_group->addAction( action );
+                }
+
+                // The budget is shared by all computed values of the application
+                auto& cache_manager = CacheManager::instance();
+                if( cache_manager.physical_memory() )
+                {
+                    auto cache_budget_menu = context_menu.addMenu( "Cache Budget" );
+                    auto cache_budget_action_group = new QActionGroup { cache_budget_menu };
+                    cache_budget_action_group->setExclusive( true );
+
+                    for( const auto percentage : { 25, 50, 75 } )
+                    {
+                        const auto budget = static_cast<size_t>( cache_manager.physical_memory() * ( percentage / 100.0 ) );
+                        const auto action = cache_budget_menu->addAction( QString::number( percentage ) + " % of Memory", [&cache_manager, budget]
+                        {
+                            cache_manager.update_budget( budget );
+                            Console::info( std::format( "Cache budget set to {} MB", budget / ( 1024 * 1024 ) ) );
+                        } );
+                        action->setCheckable( true );
+                        action->setChecked( cache_manager.budget() == budget );
+                        cache_budget_action_group->addAction( action );
+                    }
+                }
+
                 context_menu.addAction( "Reset View", [this] { this->reset_image_rectangle(); } );
                 context_menu.addSeparator();
 
@@ -390,41 +545,62 @@ void ImageViewer::mouseReleaseEvent( QMouseEvent* event )
                 context_menu.exec( event->globalPosition().toPoint() );
             }
         }
-        else if( _selection_mode == InteractionMode::eGrowSegment || _selection_mode == InteractionMode::eShrinkSegment )
+        else if( _selection_tool != SelectionTool::eBrush && ( _selection_mode == InteractionMode::eGrowSegment || _selection_mode == InteractionMode::eShrinkSegment ) )
         {
-            const auto rectangle = _selection_polygon.boundingRect().intersected( _image_rectangle );
-            if( !rectangle.isEmpty() )
-            {
-                auto begin = this->screen_to_pixel( rectangle.topLeft() );
-                auto end = this->screen_to_pixel( rectangle.bottomRight() );
-                if( begin.x > end.x ) std::swap( begin.x, end.x );
-                if( begin.y > end.y ) std::swap( begin.y, end.y );
+            const auto spatial_metadata = _database.dataset()->spatial_metadata();
+            const auto segmentation = _database.segmentation();
+            const auto segment_number = _selection_mode == InteractionMode::eGrowSegment ? _database.active_segment()->number() : 0;
 
-                const auto dataset          = _database.dataset();
-                const auto segmentation     = _database.segmentation();
-                const auto active_segment   = _database.active_segment();
+            auto polygon = QPolygonF {};
+            polygon.reserve( _selection_polygon.size() );
+            for( const auto& point : _selection_polygon )
+            {
+                polygon.append( this->screen_to_image( point ) );
+            }
 
-                const auto spatial_metadata = dataset->spatial_metadata();
-                const auto segment_number = _selection_mode == InteractionMode::eGrowSegment ? _database.active_segment()->number() : 0;
+            // Covered pixels are scan converted row by row and written as contiguous runs
+            auto spans = std::vector<rasterization::Span> {};
+            switch( _selection_tool )
+            {
+            case SelectionTool::eLasso:
+                spans = rasterization::polygon( polygon, spatial_metadata->dimensions );
+                break;
+            case SelectionTool::eRectangle:
+                spans = rasterization::rectangle( QRectF { polygon.front(), polygon.back() }, spatial_metadata->dimensions );
+                break;
+            case SelectionTool::eBrush:
+                break;
+            }
 
+            if( !spans.empty() )
+            {
                 auto segmentation_editor = segmentation->editor();
-                for( auto x = begin.x; x <= end.x; ++x )
+                for( const auto& span : spans )
                 {
-                    for( auto y = begin.y; y <= end.y; ++y )
-                    {
-                        const auto coordinates = vec2<uint32_t> { x, y };
-                        const auto screen = this->pixel_to_screen( coordinates );
-                        if( _selection_polygon.containsPoint( screen, Qt::OddEvenFill ) )
-                        {
-                            segmentation_editor.update_value( spatial_metadata->element_index( coordinates ), segment_number );
-                        }
-                    }
+                    segmentation_editor.update_range( span.row * spatial_metadata->width + span.begin, span.end - span.begin, segment_number );
                 }
             }
+
+            // Spans are ordered by row and column, so the selected element indices are already sorted
+            auto selection = std::vector<uint32_t> {};
+            for( const auto& span : spans )
+            {
+                for( auto column = span.begin; column < span.end; ++column )
+                {
+                    selection.push_back( span.row * spatial_metadata->width + column );
+                }
+            }
+            _database.update_selection( SegmentMask::from_indices( selection ) );
+        }
+
+        if( !_brush_stroke.empty() )
+        {
+            _database.segmentation()->end_history_group();
         }
 
         _selection_polygon.clear();
         _selection_mode = InteractionMode::eNone;
+        _brush_stroke.clear();
     }
 
     this->update();
@@ -446,6 +622,19 @@ void ImageViewer::mouseMoveEvent( QMouseEvent* event )
         if( _selection_mode == InteractionMode::eGrowSegment || _selection_mode == InteractionMode::eShrinkSegment )
         {
             _selection_polygon.append( event->position() );
+            if( _selection_tool == SelectionTool::eBrush )
+            {
+                // Only the painted elements and the brush outline are repainted while the stroke is in progress
+                const auto radius = _brush_radius * _image_rectangle.width() / _database.dataset()->spatial_metadata()->width + 2.0;
+                const auto outline = QRectF { -radius, -radius, 2.0 * radius, 2.0 * radius };
+                this->update( outline.translated( _cursor_position ).toAlignedRect() );
+                this->update( outline.translated( event->position() ).toAlignedRect() );
+                _cursor_position = event->position();
+
+                _brush_stroke.append( this->screen_to_image( event->position() ) );
+                this->apply_brush_stroke();
+                return;
+            }
             this->update();
         }
     }
@@ -495,6 +684,15 @@ vec2<uint32_t> ImageViewer::screen_to_pixel( QPointF screen ) const
     return pixel;
 }
 
+QPointF ImageViewer::screen_to_image( QPointF screen ) const
+{
+    const auto dimensions = _database.dataset()->spatial_metadata()->dimensions;
+    return QPointF {
+        ( screen.x() - _image_rectangle.left() ) / _image_rectangle.width() * dimensions.x,
+        ( screen.y() - _image_rectangle.top() ) / _image_rectangle.height() * dimensions.y
+    };
+}
+
 void ImageViewer::reset_image_rectangle()
 {
     const auto dataset      = _database.dataset();
@@ -667,51 +865,39 @@ except Exception as exception:
 }
 void ImageViewer::create_screenshot( uint32_t scaling ) const
 {
-    const auto filepath = scaling == 0 ? QString { "clipboard" } : QFileDialog::getSaveFileName( nullptr, "Export Image...", "", "*.png", nullptr );
+    const auto filepath = scaling == 0 ? QString { "clipboard" } : QFileDialog::getSaveFileName( nullptr, "Export Image...", "", "Images (*.png *.tif *.tiff)", nullptr );
 
     if( !filepath.isEmpty() )
     {
-        const auto dimensions = _database.dataset()->spatial_metadata()->dimensions;
-        auto image = QImage {
-            static_cast<int32_t>( dimensions.x ),
-            static_cast<int32_t>( dimensions.y ),
-            QImage::Format_RGBA8888
-        };
-        image.fill( QColor { 0, 0, 0, 0 } );
-
-        auto painter  = QPainter { &image };
-
-        // Render image
-        if( auto colormap = _colormap.lock() )
+        auto renderer = ImageRenderer { _database.dataset()->spatial_metadata()->dimensions };
+        if( const auto colormap = _colormap.lock() )
         {
-            const auto& colors = colormap->colors();
-            const auto dimensions = _database.dataset()->spatial_metadata()->dimensions;
-            const auto image = QImage { reinterpret_cast<const uchar*>( colors.data() ), static_cast<int>( dimensions.x ), static_cast<int>( dimensions.y ), QImage::Format_RGBA32FPx4 };
-            painter.setOpacity( _image_opacity );
-            painter.drawImage( image.rect(), image );
+            renderer.add_layer( colormap, _image_opacity );
         }
 
         // Render segmentation colors or false-coloring
         if( _coloring == ColoringMode::eSegmentation )
         {
-            // Render segmentation colors
-            const auto segmentation = _database.segmentation();
-            const auto& segmentation_colors = segmentation->element_colors();
-            const auto image = QImage { reinterpret_cast<const uchar*>( segmentation_colors.data() ), static_cast<int>( dimensions.x ), static_cast<int>( dimensions.y ), QImage::Format_RGBA32FPx4 };
-            painter.setOpacity( _segmentation_opacity );
-            painter.drawImage( image.rect(), image );
+            renderer.add_layer( _database.segmentation(), _segmentation_opacity );
         }
         else if( _coloring == ColoringMode::eFalseColoring )
         {
-            if( const auto colormap = _database.colormap_embedding() )
-            {
-                const auto& colors = colormap->colors();
-                const auto image = QImage { reinterpret_cast<const uchar*>( colors.data() ), static_cast<int>( dimensions.x ), static_cast<int>( dimensions.y ), QImage::Format_RGBA32FPx4 };
-                painter.setOpacity( _segmentation_opacity );
-                painter.drawImage( image.rect(), image );
-            }
+            renderer.add_layer( _database.colormap_embedding(), _segmentation_opacity );
+        }
+
+        if( _overlay_image.size() )
+        {
+            const auto overlay = QImage {
+                reinterpret_cast<const uchar*>( _overlay_image.data() ),
+                static_cast<int>( _overlay_image.dimensions()[0] ),
+                static_cast<int>( _overlay_image.dimensions()[1] ),
+                QImage::Format_RGB888
+            };
+            renderer.add_layer( overlay, _segmentation_opacity );
         }
 
+        const auto image = renderer.render( std::max( scaling, 1u ) );
+
         if( filepath == "clipboard" )
         {
             // Workaround for copying and image with transparency into the clipboard
@@ -729,7 +915,7 @@ void ImageViewer::create_screenshot( uint32_t scaling ) const
         }
         else
         {
-            const auto result = image.scaledToHeight( scaling * image.height(), Qt::FastTransformation ).save( filepath );
+            ImageRenderer::save( image, filepath );
         }
     }
 }
@@ -757,13 +943,15 @@ void ImageViewer::export_columns() const
         {
             if( auto feature = colormap_1d->feature() )
             {
-                const auto& feature_values = feature->values();
-                for( uint32_t element_index = 0; element_index < dataset->element_count(); ++element_index )
+                feature->visit_values( [&] ( const auto& feature_values )
                 {
-                    const auto coordinates = spatial_metadata->coordinates( element_index );
-                    const auto segment_number = segmentation->segment_number( element_index );
-                    stream << element_index << ',' << segment_number << ',' << coordinates.x << ',' << coordinates.y << ',' << feature_values[element_index] << '\n';
-                }
+                    for( uint32_t element_index = 0; element_index < dataset->element_count(); ++element_index )
+                    {
+                        const auto coordinates = spatial_metadata->coordinates( element_index );
+                        const auto segment_number = segmentation->segment_number( element_index );
+                        stream << element_index << ',' << segment_number << ',' << coordinates.x << ',' << coordinates.y << ',' << feature_values[element_index] << '\n';
+                    }
+                } );
             }
         }
         else
@@ -801,17 +989,19 @@ void ImageViewer::export_matrix() const
         {
             if( auto feature = colormap_1d->feature() )
             {
-                const auto& feature_values = feature->values();
-                for( uint32_t y = 0; y < spatial_metadata->dimensions.y; ++y )
+                feature->visit_values( [&] ( const auto& feature_values )
                 {
-                    stream << y;
-                    for( uint32_t x = 0; x < spatial_metadata->dimensions.x; ++x )
+                    for( uint32_t y = 0; y < spatial_metadata->dimensions.y; ++y )
                     {
-                        const auto element_index = spatial_metadata->element_index( vec2<uint32_t> { x, y } );
-                        stream << ',' << feature_values[element_index];
+                        stream << y;
+                        for( uint32_t x = 0; x < spatial_metadata->dimensions.x; ++x )
+                        {
+                            const auto element_index = spatial_metadata->element_index( vec2<uint32_t> { x, y } );
+                            stream << ',' << feature_values[element_index];
+                        }
+                        stream << '\n';
                     }
-                    stream << '\n';
-                }
+                } );
             }
         }
         else
@@ -819,4 +1009,217 @@ void ImageViewer::export_matrix() const
             QMessageBox::warning( nullptr, "", "The current colormap does not support exporting as matrix" );
         }
     }
+}
+
+QImage ImageViewer::compute_colormap_image() const
+{
+    if( const auto colormap = _colormap.lock() )
+    {
+        if( const auto& colors = colormap->colors(); colors.size() )
+        {
+            return convert_colors( colors, _database.dataset()->spatial_metadata()->dimensions );
+        }
+    }
+    return QImage {};
+}
+QImage ImageViewer::compute_colormap_preview() const
+{
+    const auto colormap = _colormap.lock();
+    const auto spatial_metadata = _database.dataset()->spatial_metadata();
+    if( !colormap || colormap->element_count() != size_t { spatial_metadata->width } * spatial_metadata->height )
+    {
+        return QImage {};
+    }
+
+    // Pixel centers of a power-of-two strided grid, coarse enough to stay within the preview budget
+    auto stride = uint32_t { 2 };
+    const auto preview_dimensions = [&]
+    {
+        return vec2<uint32_t> { ( spatial_metadata->width + stride - 1 ) / stride, ( spatial_metadata->height + stride - 1 ) / stride };
+    };
+    while( size_t { preview_dimensions().x } * preview_dimensions().y > config::progressive_preview_element_count )
+    {
+        stride *= 2;
+    }
+
+    const auto dimensions = preview_dimensions();
+    auto element_indices = std::vector<uint32_t>( size_t { dimensions.x } * dimensions.y );
+    utility::iterate_parallel( dimensions.y, [&] ( uint32_t y )
+    {
+        for( uint32_t x = 0; x < dimensions.x; ++x )
+        {
+            const auto pixel = vec2<uint32_t> {
+                std::min( x * stride + stride / 2, spatial_metadata->width - 1 ),
+                std::min( y * stride + stride / 2, spatial_metadata->height - 1 )
+            };
+            element_indices[size_t { y } * dimensions.x + x] = spatial_metadata->element_index( pixel );
+        }
+    } );
+
+    return convert_colors( colormap->sampled_colors( element_indices ), dimensions );
+}
+void ImageViewer::refine_colormap_image()
+{
+    if( const auto colormap = _colormap.lock() )
+    {
+        colormap->refine();
+        _colormap_image.value();
+        this->update();
+    }
+}
+QImage ImageViewer::compute_false_coloring_image() const
+{
+    if( const auto colormap = _database.colormap_embedding() )
+    {
+        if( const auto& colors = colormap->colors(); colors.size() )
+        {
+            return convert_colors( colors, _database.dataset()->spatial_metadata()->dimensions );
+        }
+    }
+    return QImage {};
+}
+QImage ImageViewer::compute_segmentation_image() const
+{
+    const auto segmentation = _database.segmentation();
+    const auto dimensions = _database.dataset()->spatial_metadata()->dimensions;
+    const auto& segment_numbers = segmentation->segment_numbers();
+    const auto palette = segmentation->palette();
+
+    // Up to 256 segments fit into an indexed image, recoloring then only touches the color table
+    if( palette.size() <= 256 )
+    {
+        auto image = QImage { static_cast<int>( dimensions.x ), static_cast<int>( dimensions.y ), QImage::Format_Indexed8 };
+        image.setColorTable( palette );
+
+        const auto bits = image.bits();
+        const auto bytes_per_line = static_cast<size_t>( image.bytesPerLine() );
+        utility::iterate_parallel( dimensions.y, [&] ( uint32_t y )
+        {
+            auto scanline = bits + y * bytes_per_line;
+            const auto row = segment_numbers.data() + size_t { y } * dimensions.x;
+            for( uint32_t x = 0; x < dimensions.x; ++x )
+            {
+                scanline[x] = static_cast<uchar>( row[x] );
+            }
+        } );
+        return image;
+    }
+
+    auto image = QImage { static_cast<int>( dimensions.x ), static_cast<int>( dimensions.y ), QImage::Format_ARGB32 };
+    const auto bits = image.bits();
+    const auto bytes_per_line = static_cast<size_t>( image.bytesPerLine() );
+    utility::iterate_parallel( dimensions.y, [&] ( uint32_t y )
+    {
+        auto scanline = reinterpret_cast<QRgb*>( bits + y * bytes_per_line );
+        const auto row = segment_numbers.data() + size_t { y } * dimensions.x;
+        for( uint32_t x = 0; x < dimensions.x; ++x )
+        {
+            scanline[x] = palette[row[x]];
+        }
+    } );
+    return image;
+}
+void ImageViewer::update_segmentation_image()
+{
+    const auto segmentation = _database.segmentation();
+    if( segmentation->full_change() )
+    {
+        _segmentation_pyramid.invalidate();
+        _segmentation_image.invalidate();
+        this->update();
+        return;
+    }
+
+    const auto& segment_numbers = segmentation->segment_numbers();
+    const auto dimensions = _database.dataset()->spatial_metadata()->dimensions;
+
+    auto changed_region = QRect {};
+    for( const auto& change : segmentation->changes() )
+    {
+        changed_region |= QRect { static_cast<int>( change.element_index % dimensions.x ), static_cast<int>( change.element_index / dimensions.x ), 1, 1 };
+    }
+    _segmentation_pyramid.invalidate( changed_region );
+
+    // Only the changed elements are written into the cached image
+    const auto updated = _segmentation_image.modify( [&] ( QImage& image )
+    {
+        const auto palette = image.format() == QImage::Format_Indexed8 ? QList<QRgb> {} : segmentation->palette();
+        for( const auto& change : segmentation->changes() )
+        {
+            const auto x = static_cast<int>( change.element_index % dimensions.x );
+            const auto y = static_cast<int>( change.element_index / dimensions.x );
+            if( image.format() == QImage::Format_Indexed8 )
+            {
+                image.scanLine( y )[x] = static_cast<uchar>( segment_numbers[change.element_index] );
+            }
+            else
+            {
+                reinterpret_cast<QRgb*>( image.scanLine( y ) )[x] = palette[segment_numbers[change.element_index]];
+            }
+        }
+    } );
+
+    if( !updated )
+    {
+        _segmentation_image.invalidate();
+    }
+
+    // Only the screen area of the changed elements is repainted
+    if( !changed_region.isEmpty() )
+    {
+        const auto scale_x = _image_rectangle.width() / dimensions.x;
+        const auto scale_y = _image_rectangle.height() / dimensions.y;
+        const auto dirty_rectangle = QRectF {
+            _image_rectangle.left() + changed_region.left() * scale_x,
+            _image_rectangle.top() + changed_region.top() * scale_y,
+            changed_region.width() * scale_x,
+            changed_region.height() * scale_y
+        };
+        this->update( dirty_rectangle.toAlignedRect().adjusted( -1, -1, 1, 1 ) );
+    }
+}
+void ImageViewer::update_segmentation_palette()
+{
+    const auto segmentation = _database.segmentation();
+    const auto palette = segmentation->palette();
+
+    // Indexed images only need a new color table, direct color images are recomputed
+    _segmentation_pyramid.invalidate();
+    auto indexed = false;
+    _segmentation_image.modify( [&] ( QImage& image )
+    {
+        if( indexed = image.format() == QImage::Format_Indexed8 )
+        {
+            image.setColorTable( palette );
+        }
+    } );
+
+    if( !indexed )
+    {
+        _segmentation_image.invalidate();
+    }
+    this->update();
+}
+void ImageViewer::apply_brush_stroke()
+{
+    if( _brush_stroke.empty() )
+    {
+        return;
+    }
+
+    const auto spatial_metadata = _database.dataset()->spatial_metadata();
+    const auto segment_number = _selection_mode == InteractionMode::eGrowSegment ? _database.active_segment()->number() : 0;
+    const auto spans = rasterization::stroke( _brush_stroke, _brush_radius, spatial_metadata->dimensions );
+
+    // The last point is kept so the next batch continues the stroke without gaps
+    _brush_stroke = QPolygonF { _brush_stroke.back() };
+
+    if( !spans.empty() )
+    {
+        auto segmentation_editor = _database.segmentation()->editor();
+        for( const auto& span : spans )
+        {
+            segmentation_editor.update_range( span.row * spatial_metadata->width + span.begin, span.end - span.begin, segment_number );
+        }
+    }
 }
\ No newline at end of file
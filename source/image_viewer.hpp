@@ -1,8 +1,11 @@
 #pragma once
 #include "database.hpp"
+#include "image_pyramid.hpp"
 #include "utility.hpp"
 
+#include <qimage.h>
 #include <qsharedpointer.h>
+#include <qtimer.h>
 #include <qwidget.h>
 
 // ----- ImageViewer ----- //
@@ -25,6 +28,13 @@ public:
         eOpacitySlider
     };
 
+    enum class SelectionTool
+    {
+        eLasso,
+        eRectangle,
+        eBrush
+    };
+
     ImageViewer( Database& database );
 
     void update_colormap( QSharedPointer<Colormap> colormap );
@@ -41,6 +51,7 @@ public:
 
     QPointF pixel_to_screen( vec2<uint32_t> pixel ) const;
     vec2<uint32_t> screen_to_pixel( QPointF screen ) const;
+    QPointF screen_to_image( QPointF screen ) const;
 
 private:
     void reset_image_rectangle();
@@ -49,10 +60,35 @@ private:
     void export_columns() const;
     void export_matrix() const;
 
+    QImage compute_colormap_image() const;
+    QImage compute_colormap_preview() const;
+    void refine_colormap_image();
+    QImage compute_false_coloring_image() const;
+    QImage compute_segmentation_image() const;
+    void update_segmentation_image();
+    void update_segmentation_palette();
+    void apply_brush_stroke();
+
     Database& _database;
 
     ColoringMode _coloring = ColoringMode::eSegmentation;
     QWeakPointer<Colormap> _colormap;
+    Computed<QImage> _colormap_image;
+    CacheResidency _colormap_residency;
+
+    // Strided preview shown for large colormaps until the full resolution image is computed after a pause
+    Computed<QImage> _colormap_preview;
+    QTimer _refine_timer;
+
+    Computed<QImage> _false_coloring_image;
+
+    // Indexed segment numbers are patched in place, only the affected tiles of its pyramid are rebuilt
+    Computed<QImage> _segmentation_image;
+    CacheResidency _segmentation_residency;
+
+    ImagePyramid _colormap_pyramid;
+    ImagePyramid _false_coloring_pyramid;
+    ImagePyramid _segmentation_pyramid;
     Tensor::with_rank<3>::with_type<uint8_t> _overlay_image;
 
     double _image_opacity = 1.0;
@@ -64,4 +100,7 @@ private:
     QPointF _cursor_position;
     QPolygonF _selection_polygon;
     InteractionMode _selection_mode = InteractionMode::eNone;
+    SelectionTool _selection_tool = SelectionTool::eLasso;
+    double _brush_radius = 5.0;
+    QPolygonF _brush_stroke;
 };
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "dataset_alignment_dialog.hpp"
 #include "dataset_importer.hpp"
 #include "embedding_creator.hpp"
+#include "image_renderer.hpp"
 #include "python.hpp"
 #include "workspace.hpp"
 #include "utility.hpp"
@@ -13,6 +14,32 @@
 
 int main( int argc, char** argv )
 {
+    const auto initialize_python = []
+    {
+        py::interpreter::python_home = config::executable_directory.absoluteFilePath( "python" ).toStdWString();
+        py::interpreter::module_search_paths = {
+            py::interpreter::python_home,
+            py::interpreter::python_home + L"\\python313.zip",
+            py::interpreter::python_home + L"\\Lib\\site-packages"
+        };
+        return py::interpreter::initialize();
+    };
+
+    // Headless batch rendering runs without widgets, display or OpenGL
+    if( argc > 1 && std::string_view { argv[1] } == "--render" )
+    {
+        QLocale::setDefault( QLocale::c() );
+        auto application = QCoreApplication { argc, argv };
+        config::executable_directory = QDir { application.applicationDirPath() };
+
+        Console::initialize();
+        if( initialize_python() )
+        {
+            return 1;
+        }
+        return ImageRenderer::execute_batch( application.arguments() );
+    }
+
     // Initialize application
     auto surface_format = QSurfaceFormat {};
     surface_format.setProfile( QSurfaceFormat::CoreProfile );
@@ -44,13 +71,7 @@ int main( int argc, char** argv )
     Console::info( std::format( "Executable directory: {}", config::executable_directory.absolutePath().toStdString() ) );
 
     // Initialize python
-    py::interpreter::python_home = config::executable_directory.absoluteFilePath( "python" ).toStdWString();
-    py::interpreter::module_search_paths = {
-        py::interpreter::python_home,
-        py::interpreter::python_home + L"\\python313.zip",
-        py::interpreter::python_home + L"\\Lib\\site-packages"
-    };
-    if( py::interpreter::initialize() )
+    if( initialize_python() )
     {
         return 0;
     }
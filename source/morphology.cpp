@@ -0,0 +1,245 @@
+#include "morphology.hpp"
+
+#include "dataset.hpp"
+#include "segmentation.hpp"
+
+#include <bit>
+
+// ----- BitMask ----- //
+
+BitMask::BitMask( vec2<uint32_t> dimensions ) : _dimensions { dimensions }, _words_per_row { ( dimensions.x + 63 ) / 64 }, _words { size_t { _words_per_row } * dimensions.y, 0 }
+{
+}
+BitMask BitMask::from_segment( const Segmentation& segmentation, vec2<uint32_t> dimensions, uint32_t segment_number )
+{
+    auto mask = BitMask { dimensions };
+    const auto& segment_numbers = segmentation.segment_numbers();
+
+    utility::iterate_parallel( dimensions.y, [&] ( uint32_t y )
+    {
+        auto words = mask.row( y );
+        const auto row = segment_numbers.data() + size_t { y } * dimensions.x;
+        for( uint32_t x = 0; x < dimensions.x; ++x )
+        {
+            words[x / 64] |= uint64_t { row[x] == segment_number } << ( x % 64 );
+        }
+    } );
+    return mask;
+}
+
+vec2<uint32_t> BitMask::dimensions() const noexcept
+{
+    return _dimensions;
+}
+uint32_t BitMask::words_per_row() const noexcept
+{
+    return _words_per_row;
+}
+
+bool BitMask::value( uint32_t x, uint32_t y ) const
+{
+    return ( this->row( y )[x / 64] >> ( x % 64 ) ) & 1;
+}
+const uint64_t* BitMask::row( uint32_t y ) const
+{
+    return _words.data() + size_t { y } * _words_per_row;
+}
+uint64_t* BitMask::row( uint32_t y )
+{
+    return _words.data() + size_t { y } * _words_per_row;
+}
+
+BitMask BitMask::dilated( uint32_t radius ) const
+{
+    auto mask = *this;
+    for( uint32_t i = 0; i < radius; ++i )
+    {
+        mask = mask.step( true );
+    }
+    return mask;
+}
+BitMask BitMask::eroded( uint32_t radius ) const
+{
+    auto mask = *this;
+    for( uint32_t i = 0; i < radius; ++i )
+    {
+        mask = mask.step( false );
+    }
+    return mask;
+}
+BitMask BitMask::opened( uint32_t radius ) const
+{
+    return this->eroded( radius ).dilated( radius );
+}
+BitMask BitMask::closed( uint32_t radius ) const
+{
+    return this->dilated( radius ).eroded( radius );
+}
+BitMask BitMask::filled() const
+{
+    const auto width = _dimensions.x;
+    const auto height = _dimensions.y;
+
+    // Unset pixels reachable from the image border are background, the remaining unset pixels are holes
+    auto background = BitMask { _dimensions };
+    const auto open = [&] ( uint32_t x, uint32_t y )
+    {
+        return !this->value( x, y ) && !background.value( x, y );
+    };
+
+    // Scanline flood fill, each seed fills its horizontal run and seeds the runs above and below it
+    auto seeds = std::vector<vec2<uint32_t>> {};
+    for( uint32_t x = 0; x < width && height; ++x )
+    {
+        seeds.push_back( vec2<uint32_t> { x, 0 } );
+        seeds.push_back( vec2<uint32_t> { x, height - 1 } );
+    }
+    for( uint32_t y = 0; y < height && width; ++y )
+    {
+        seeds.push_back( vec2<uint32_t> { 0, y } );
+        seeds.push_back( vec2<uint32_t> { width - 1, y } );
+    }
+
+    while( !seeds.empty() )
+    {
+        const auto seed = seeds.back();
+        seeds.pop_back();
+        if( !open( seed.x, seed.y ) )
+        {
+            continue;
+        }
+
+        auto begin = seed.x;
+        auto end = seed.x + 1;
+        while( begin > 0 && open( begin - 1, seed.y ) ) --begin;
+        while( end < width && open( end, seed.y ) ) ++end;
+
+        auto words = background.row( seed.y );
+        for( auto x = begin; x < end; ++x )
+        {
+            words[x / 64] |= uint64_t { 1 } << ( x % 64 );
+        }
+
+        for( const auto y : { seed.y - 1, seed.y + 1 } )
+        {
+            if( y >= height )
+            {
+                continue;
+            }
+            for( auto x = begin; x < end; ++x )
+            {
+                if( open( x, y ) && ( x == begin || !open( x - 1, y ) ) )
+                {
+                    seeds.push_back( vec2<uint32_t> { x, y } );
+                }
+            }
+        }
+    }
+
+    auto mask = BitMask { _dimensions };
+    const auto last_word_mask = width % 64 ? ( uint64_t { 1 } << ( width % 64 ) ) - 1 : ~uint64_t { 0 };
+    utility::iterate_parallel( height, [&] ( uint32_t y )
+    {
+        const auto background_words = background.row( y );
+        auto words = mask.row( y );
+        for( uint32_t word = 0; word < _words_per_row; ++word )
+        {
+            words[word] = ~background_words[word];
+        }
+        if( _words_per_row )
+        {
+            words[_words_per_row - 1] &= last_word_mask;
+        }
+    } );
+    return mask;
+}
+
+BitMask BitMask::step( bool dilate ) const
+{
+    const auto last_word_mask = _dimensions.x % 64 ? ( uint64_t { 1 } << ( _dimensions.x % 64 ) ) - 1 : ~uint64_t { 0 };
+
+    // Horizontal pass shifts whole words by one pixel, carrying the boundary bits of the neighboring words
+    auto horizontal = BitMask { _dimensions };
+    utility::iterate_parallel( _dimensions.y, [&] ( uint32_t y )
+    {
+        const auto source = this->row( y );
+        auto target = horizontal.row( y );
+        for( uint32_t word = 0; word < _words_per_row; ++word )
+        {
+            const auto previous = word > 0 ? source[word - 1] : 0;
+            const auto next = word + 1 < _words_per_row ? source[word + 1] : 0;
+            const auto left = ( source[word] << 1 ) | ( previous >> 63 );
+            const auto right = ( source[word] >> 1 ) | ( next << 63 );
+            target[word] = dilate ? ( source[word] | left | right ) : ( source[word] & left & right );
+        }
+        if( _words_per_row )
+        {
+            target[_words_per_row - 1] &= last_word_mask;
+        }
+    } );
+
+    // Vertical pass combines each row with its neighboring rows word by word
+    auto mask = BitMask { _dimensions };
+    utility::iterate_parallel( _dimensions.y, [&] ( uint32_t y )
+    {
+        const auto center = horizontal.row( y );
+        const auto above = y > 0 ? horizontal.row( y - 1 ) : nullptr;
+        const auto below = y + 1 < _dimensions.y ? horizontal.row( y + 1 ) : nullptr;
+        auto target = mask.row( y );
+        for( uint32_t word = 0; word < _words_per_row; ++word )
+        {
+            const auto above_word = above ? above[word] : 0;
+            const auto below_word = below ? below[word] : 0;
+            target[word] = dilate ? ( center[word] | above_word | below_word ) : ( center[word] & above_word & below_word );
+        }
+    } );
+    return mask;
+}
+
+// ----- morphology ----- //
+
+namespace morphology
+{
+    uint32_t apply( const Dataset& dataset, Segmentation& segmentation, uint32_t segment_number, Operation operation, uint32_t radius )
+    {
+        const auto spatial_metadata = dataset.spatial_metadata();
+        if( !spatial_metadata || segment_number == 0 || segment_number >= segmentation.segment_count() )
+        {
+            return 0;
+        }
+
+        const auto dimensions = spatial_metadata->dimensions;
+        const auto mask = BitMask::from_segment( segmentation, dimensions, segment_number );
+        const auto result = [&]
+        {
+            switch( operation )
+            {
+            case Operation::eDilate: return mask.dilated( radius );
+            case Operation::eErode: return mask.eroded( radius );
+            case Operation::eOpen: return mask.opened( radius );
+            case Operation::eClose: return mask.closed( radius );
+            default: return mask.filled();
+            }
+        }();
+
+        // Only words that differ are expanded into individual elements
+        auto changed_count = uint32_t { 0 };
+        auto editor = segmentation.editor();
+        for( uint32_t y = 0; y < dimensions.y; ++y )
+        {
+            const auto previous_words = mask.row( y );
+            const auto words = result.row( y );
+            for( uint32_t word = 0; word < mask.words_per_row(); ++word )
+            {
+                for( auto difference = previous_words[word] ^ words[word]; difference; difference &= difference - 1 )
+                {
+                    const auto bit = static_cast<uint32_t>( std::countr_zero( difference ) );
+                    const auto element_index = y * dimensions.x + word * 64 + bit;
+                    editor.update_value( element_index, ( words[word] >> bit ) & 1 ? segment_number : 0 );
+                    ++changed_count;
+                }
+            }
+        }
+        return changed_count;
+    }
+}
\ No newline at end of file
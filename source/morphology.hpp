@@ -0,0 +1,50 @@
+#pragma once
+#include "utility.hpp"
+
+class Dataset;
+class Segmentation;
+
+// ----- BitMask ----- //
+
+class BitMask
+{
+public:
+    BitMask( vec2<uint32_t> dimensions );
+    static BitMask from_segment( const Segmentation& segmentation, vec2<uint32_t> dimensions, uint32_t segment_number );
+
+    vec2<uint32_t> dimensions() const noexcept;
+    uint32_t words_per_row() const noexcept;
+
+    bool value( uint32_t x, uint32_t y ) const;
+    const uint64_t* row( uint32_t y ) const;
+    uint64_t* row( uint32_t y );
+
+    // Square structuring elements of the given radius, pixels outside of the image count as unset
+    BitMask dilated( uint32_t radius ) const;
+    BitMask eroded( uint32_t radius ) const;
+    BitMask opened( uint32_t radius ) const;
+    BitMask closed( uint32_t radius ) const;
+    BitMask filled() const;
+
+private:
+    BitMask step( bool dilate ) const;
+
+    vec2<uint32_t> _dimensions;
+    uint32_t _words_per_row;
+    Array<uint64_t> _words;
+};
+
+namespace morphology
+{
+    enum class Operation
+    {
+        eDilate,
+        eErode,
+        eOpen,
+        eClose,
+        eFillHoles
+    };
+
+    // Applies the operation to the mask of a segment, added elements are assigned to the segment and removed ones to segment 0
+    uint32_t apply( const Dataset& dataset, Segmentation& segmentation, uint32_t segment_number, Operation operation, uint32_t radius = 1 );
+}
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include "quantile_sketch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+// ----- QuantileSketch ----- //
+
+QuantileSketch::QuantileSketch( uint32_t k ) : _k { std::max( k, 8u ) }, _levels( 1 )
+{
+}
+
+uint32_t QuantileSketch::k() const noexcept
+{
+    return _k;
+}
+uint64_t QuantileSketch::count() const noexcept
+{
+    return _count;
+}
+bool QuantileSketch::exact() const noexcept
+{
+    return _compactions == 0;
+}
+
+void QuantileSketch::insert( double value )
+{
+    _levels.front().push_back( value );
+    ++_count;
+
+    if( _levels.front().size() >= this->capacity( 0 ) && this->retained_count() >= this->retained_capacity() )
+    {
+        this->compress();
+    }
+}
+void QuantileSketch::merge( const QuantileSketch& other )
+{
+    if( _levels.size() < other._levels.size() )
+    {
+        _levels.resize( other._levels.size() );
+    }
+    for( size_t level = 0; level < other._levels.size(); ++level )
+    {
+        _levels[level].insert( _levels[level].end(), other._levels[level].begin(), other._levels[level].end() );
+    }
+
+    _count += other._count;
+    _compactions += other._compactions;
+    _compaction_error += other._compaction_error;
+
+    while( this->retained_count() > this->retained_capacity() )
+    {
+        this->compress();
+    }
+}
+
+double QuantileSketch::quantile( double quantile ) const
+{
+    if( _count == 0 )
+    {
+        return 0.0;
+    }
+
+    auto items = std::vector<std::pair<double, uint64_t>> {};
+    items.reserve( this->retained_count() );
+    for( size_t level = 0; level < _levels.size(); ++level )
+    {
+        for( const auto value : _levels[level] )
+        {
+            items.emplace_back( value, uint64_t { 1 } << level );
+        }
+    }
+    std::sort( items.begin(), items.end() );
+
+    // Same position convention as the exact quantiles, interpolating between the neighbouring ranks
+    const auto position = ( _count - 1 ) * std::clamp( quantile, 0.0, 1.0 );
+    const auto value_at = [&items] ( uint64_t rank )
+    {
+        auto cumulative = uint64_t { 0 };
+        for( const auto& [value, weight] : items )
+        {
+            cumulative += weight;
+            if( cumulative > rank )
+            {
+                return value;
+            }
+        }
+        return items.back().first;
+    };
+
+    const auto lower_rank = static_cast<uint64_t>( std::floor( position ) );
+    const auto upper_rank = static_cast<uint64_t>( std::ceil( position ) );
+    const auto lower_value = value_at( lower_rank );
+    if( lower_rank == upper_rank )
+    {
+        return lower_value;
+    }
+    return lower_value + ( position - lower_rank ) * ( value_at( upper_rank ) - lower_value );
+}
+double QuantileSketch::rank_error() const noexcept
+{
+    // The offsets are not randomized, so this is the deterministic worst case rather than the probabilistic KLL bound
+    return _count == 0 ? 0.0 : std::min( static_cast<double>( _compaction_error ) / _count, 1.0 );
+}
+
+uint32_t QuantileSketch::capacity( uint32_t level ) const noexcept
+{
+    const auto depth = static_cast<double>( _levels.size() - 1 - level );
+    return std::max( 2u, static_cast<uint32_t>( std::ceil( _k * std::pow( 2.0 / 3.0, depth ) ) ) );
+}
+size_t QuantileSketch::retained_count() const noexcept
+{
+    auto count = size_t { 0 };
+    for( const auto& level : _levels )
+    {
+        count += level.size();
+    }
+    return count;
+}
+size_t QuantileSketch::retained_capacity() const noexcept
+{
+    auto capacity = size_t { 0 };
+    for( uint32_t level = 0; level < _levels.size(); ++level )
+    {
+        capacity += this->capacity( level );
+    }
+    return capacity;
+}
+void QuantileSketch::compress()
+{
+    for( uint32_t level = 0; level < _levels.size(); ++level )
+    {
+        if( _levels[level].size() < this->capacity( level ) )
+        {
+            continue;
+        }
+
+        if( level + 1 == _levels.size() )
+        {
+            _levels.emplace_back();
+        }
+
+        auto& items = _levels[level];
+        auto& promoted = _levels[level + 1];
+
+        // An odd item stays on its level, the offset alternates deterministically between compactions
+        auto leftover = std::optional<double> {};
+        if( items.size() % 2 == 1 )
+        {
+            leftover = items.back();
+            items.pop_back();
+        }
+
+        std::sort( items.begin(), items.end() );
+        for( size_t index = _compactions % 2; index < items.size(); index += 2 )
+        {
+            promoted.push_back( items[index] );
+        }
+
+        items.clear();
+        if( leftover.has_value() )
+        {
+            items.push_back( *leftover );
+        }
+
+        // Compacting sorted pairs shifts the rank of any value by at most the weight of one item on this level
+        _compaction_error += uint64_t { 1 } << level;
+        ++_compactions;
+        return;
+    }
+}
\ No newline at end of file
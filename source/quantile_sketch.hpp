@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ----- QuantileSketch ----- //
+
+// KLL sketch: items on level h carry a weight of 2^h, full levels are compacted by keeping every other sorted item at alternating offsets
+class QuantileSketch
+{
+public:
+    QuantileSketch( uint32_t k = 200 );
+
+    uint32_t k() const noexcept;
+    uint64_t count() const noexcept;
+    bool exact() const noexcept;
+
+    void insert( double value );
+    void merge( const QuantileSketch& other );
+
+    double quantile( double quantile ) const;
+    double rank_error() const noexcept;
+
+private:
+    uint32_t capacity( uint32_t level ) const noexcept;
+    size_t retained_count() const noexcept;
+    size_t retained_capacity() const noexcept;
+    void compress();
+
+    uint32_t _k;
+    uint64_t _count = 0;
+    uint32_t _compactions = 0;
+    uint64_t _compaction_error = 0;
+    std::vector<std::vector<double>> _levels;
+};
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "rasterization.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    // Rows whose pixel centers lie in [minimum, maximum)
+    std::pair<uint32_t, uint32_t> row_range( double minimum, double maximum, uint32_t height )
+    {
+        const auto first = std::clamp( std::ceil( minimum - 0.5 ), 0.0, static_cast<double>( height ) );
+        const auto last = std::clamp( std::ceil( maximum - 0.5 ), 0.0, static_cast<double>( height ) );
+        return { static_cast<uint32_t>( first ), static_cast<uint32_t>( last ) };
+    }
+
+    // Columns whose pixel centers lie in [left, right)
+    std::pair<uint32_t, uint32_t> column_range( double left, double right, uint32_t width )
+    {
+        return row_range( left, right, width );
+    }
+
+    std::vector<rasterization::Span> flatten( const std::vector<std::vector<rasterization::Span>>& rows )
+    {
+        auto span_count = size_t { 0 };
+        for( const auto& row : rows ) span_count += row.size();
+
+        auto spans = std::vector<rasterization::Span> {};
+        spans.reserve( span_count );
+        for( const auto& row : rows ) spans.insert( spans.end(), row.begin(), row.end() );
+        return spans;
+    }
+}
+
+namespace rasterization
+{
+    std::vector<Span> polygon( const QPolygonF& polygon, vec2<uint32_t> dimensions )
+    {
+        if( polygon.size() < 3 )
+        {
+            return {};
+        }
+
+        // Edge crossings are bucketed per row, each edge only visits the rows it spans
+        auto crossings = std::vector<std::vector<double>>( dimensions.y );
+        for( qsizetype i = 0; i < polygon.size(); ++i )
+        {
+            auto a = polygon[i];
+            auto b = polygon[( i + 1 ) % polygon.size()];
+            if( a.y() == b.y() ) continue;
+            if( a.y() > b.y() ) std::swap( a, b );
+
+            const auto slope = ( b.x() - a.x() ) / ( b.y() - a.y() );
+            const auto [first, last] = row_range( a.y(), b.y(), dimensions.y );
+            for( auto row = first; row < last; ++row )
+            {
+                crossings[row].push_back( a.x() + ( row + 0.5 - a.y() ) * slope );
+            }
+        }
+
+        // Even-odd pairs of sorted crossings enclose the covered runs
+        auto rows = std::vector<std::vector<Span>>( dimensions.y );
+        utility::iterate_parallel( dimensions.y, [&] ( uint32_t row )
+        {
+            auto& row_crossings = crossings[row];
+            std::sort( row_crossings.begin(), row_crossings.end() );
+            for( size_t i = 0; i + 1 < row_crossings.size(); i += 2 )
+            {
+                const auto [begin, end] = column_range( row_crossings[i], row_crossings[i + 1], dimensions.x );
+                if( begin < end ) rows[row].push_back( Span { row, begin, end } );
+            }
+        } );
+        return flatten( rows );
+    }
+
+    std::vector<Span> rectangle( const QRectF& rectangle, vec2<uint32_t> dimensions )
+    {
+        const auto normalized = rectangle.normalized();
+        const auto [first, last] = row_range( normalized.top(), normalized.bottom(), dimensions.y );
+        const auto [begin, end] = column_range( normalized.left(), normalized.right(), dimensions.x );
+
+        auto spans = std::vector<Span> {};
+        if( begin < end )
+        {
+            spans.reserve( last - first );
+            for( auto row = first; row < last; ++row )
+            {
+                spans.push_back( Span { row, begin, end } );
+            }
+        }
+        return spans;
+    }
+
+    std::vector<Span> stroke( const QPolygonF& path, double radius, vec2<uint32_t> dimensions )
+    {
+        if( path.empty() || radius <= 0.0 )
+        {
+            return {};
+        }
+
+        // The stroke is the union of capsules around each path segment, a single point forms a disc
+        auto segments = std::vector<std::pair<QPointF, QPointF>> {};
+        segments.reserve( std::max<qsizetype>( path.size() - 1, 1 ) );
+        segments.emplace_back( path.front(), path.size() > 1 ? path[1] : path.front() );
+        for( qsizetype i = 2; i < path.size(); ++i )
+        {
+            segments.emplace_back( path[i - 1], path[i] );
+        }
+
+        // Only the rows covered by the stroke are bucketed, strokes are usually short compared to the image
+        auto segment_rows = std::vector<std::pair<uint32_t, uint32_t>> {};
+        segment_rows.reserve( segments.size() );
+        auto first_row = dimensions.y;
+        auto last_row = uint32_t { 0 };
+        for( const auto& [a, b] : segments )
+        {
+            const auto [first, last] = row_range( std::min( a.y(), b.y() ) - radius, std::max( a.y(), b.y() ) + radius, dimensions.y );
+            segment_rows.emplace_back( first, last );
+            if( first < last )
+            {
+                first_row = std::min( first_row, first );
+                last_row = std::max( last_row, last );
+            }
+        }
+
+        if( first_row >= last_row )
+        {
+            return {};
+        }
+
+        auto row_segments = std::vector<std::vector<uint32_t>>( last_row - first_row );
+        for( uint32_t i = 0; i < segments.size(); ++i )
+        {
+            for( auto row = segment_rows[i].first; row < segment_rows[i].second; ++row )
+            {
+                row_segments[row - first_row].push_back( i );
+            }
+        }
+
+        auto rows = std::vector<std::vector<Span>>( last_row - first_row );
+        utility::iterate_parallel( last_row - first_row, [&] ( uint32_t offset )
+        {
+            const auto row = first_row + offset;
+            const auto y = row + 0.5;
+
+            // A capsule is convex, so its intersection with the row is the hull of its discs and its body
+            auto intervals = std::vector<std::pair<double, double>> {};
+            intervals.reserve( row_segments[offset].size() );
+            for( const auto i : row_segments[offset] )
+            {
+                const auto& [a, b] = segments[i];
+                auto left = std::numeric_limits<double>::infinity();
+                auto right = -std::numeric_limits<double>::infinity();
+
+                for( const auto& center : { a, b } )
+                {
+                    const auto dy = y - center.y();
+                    if( const auto squared = radius * radius - dy * dy; squared >= 0.0 )
+                    {
+                        const auto dx = std::sqrt( squared );
+                        left = std::min( left, center.x() - dx );
+                        right = std::max( right, center.x() + dx );
+                    }
+                }
+
+                const auto direction = b - a;
+                if( const auto length = std::hypot( direction.x(), direction.y() ); length > 0.0 )
+                {
+                    const auto offset = QPointF { -direction.y(), direction.x() } * ( radius / length );
+                    const auto corners = std::array { a + offset, b + offset, b - offset, a - offset };
+                    for( size_t corner = 0; corner < corners.size(); ++corner )
+                    {
+                        const auto& p = corners[corner];
+                        const auto& q = corners[( corner + 1 ) % corners.size()];
+                        if( ( p.y() <= y ) != ( q.y() <= y ) )
+                        {
+                            const auto x = p.x() + ( y - p.y() ) * ( q.x() - p.x() ) / ( q.y() - p.y() );
+                            left = std::min( left, x );
+                            right = std::max( right, x );
+                        }
+                    }
+                }
+
+                if( left <= right ) intervals.emplace_back( left, right );
+            }
+
+            std::sort( intervals.begin(), intervals.end() );
+            for( size_t i = 0; i < intervals.size(); )
+            {
+                auto [left, right] = intervals[i];
+                for( ++i; i < intervals.size() && intervals[i].first <= right; ++i )
+                {
+                    right = std::max( right, intervals[i].second );
+                }
+
+                const auto [begin, end] = column_range( left, right, dimensions.x );
+                if( begin < end ) rows[offset].push_back( Span { row, begin, end } );
+            }
+        } );
+        return flatten( rows );
+    }
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+#include "utility.hpp"
+
+#include <qpolygon.h>
+#include <qrect.h>
+
+// ----- Rasterization ----- //
+
+namespace rasterization
+{
+    // Half-open run of covered pixels [begin, end) within one row
+    struct Span
+    {
+        uint32_t row;
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    // All shapes are given in continuous pixel coordinates, a pixel is covered when its center lies inside the shape
+    std::vector<Span> polygon( const QPolygonF& polygon, vec2<uint32_t> dimensions );
+    std::vector<Span> rectangle( const QRectF& rectangle, vec2<uint32_t> dimensions );
+    std::vector<Span> stroke( const QPolygonF& path, double radius, vec2<uint32_t> dimensions );
+}
\ No newline at end of file
@@ -0,0 +1,482 @@
+#include "scatter_viewer.hpp"
+
+#include "configuration.hpp"
+#include "console.hpp"
+#include "dataset.hpp"
+#include "feature.hpp"
+#include "feature_manager.hpp"
+#include "segmentation.hpp"
+
+#include <qactiongroup.h>
+#include <qevent.h>
+#include <qmenu.h>
+#include <qpainter.h>
+#include <qspinbox.h>
+#include <qwidgetaction.h>
+
+ScatterViewer::ScatterViewer( Database& database ) : _database { database }
+{
+    this->setMouseTracking( true );
+
+    _histogram.update_segmentation( _database.segmentation() );
+    _image.initialize( std::bind( &ScatterViewer::compute_image, this ) );
+
+    QObject::connect( &_histogram, &Histogram2D::counts_changed, this, &ScatterViewer::update_axes );
+    QObject::connect( &_histogram, &Histogram2D::densities_changed, &_image, &ComputedObject::invalidate );
+    QObject::connect( &_image, &ComputedObject::changed, this, qOverload<>( &QWidget::update ) );
+
+    const auto segmentation = _database.segmentation();
+    QObject::connect( segmentation.get(), &Segmentation::segment_color_changed, &_image, &ComputedObject::invalidate );
+    QObject::connect( &_database, &Database::highlighted_element_index_changed, this, qOverload<>( &QWidget::update ) );
+}
+
+QSharedPointer<const Feature> ScatterViewer::xfeature() const
+{
+    return _histogram.xfeature();
+}
+void ScatterViewer::update_xfeature( QSharedPointer<const Feature> feature )
+{
+    _histogram.update_xfeature( feature );
+    _xfeature_residency.reset( feature ? &feature->computed_values() : nullptr );
+}
+
+QSharedPointer<const Feature> ScatterViewer::yfeature() const
+{
+    return _histogram.yfeature();
+}
+void ScatterViewer::update_yfeature( QSharedPointer<const Feature> feature )
+{
+    _histogram.update_yfeature( feature );
+    _yfeature_residency.reset( feature ? &feature->computed_values() : nullptr );
+}
+
+void ScatterViewer::paintEvent( QPaintEvent* event )
+{
+    auto painter = QPainter { this };
+    painter.setRenderHint( QPainter::Antialiasing, true );
+    painter.setClipRect( this->content_rectangle() );
+
+    const auto content_rectangle = this->content_rectangle();
+    const auto xfeature = _histogram.xfeature();
+    const auto yfeature = _histogram.yfeature();
+
+    // Render density image
+    const auto xrange = _histogram.xrange();
+    const auto yrange = _histogram.yrange();
+    const auto image_rectangle = QRectF {
+        this->world_to_screen( QPointF { xrange.lower, yrange.upper } ),
+        this->world_to_screen( QPointF { xrange.upper, yrange.lower } )
+    };
+    painter.drawImage( image_rectangle, *_image );
+
+    // Render selection polygon
+    if( !_selection_polygon.empty() )
+    {
+        const auto stroke_color = _selection_mode == InteractionMode::eGrowSegment ? _database.active_segment()->color().qcolor() : QColor { 200, 200, 200 };
+        auto brush_color = stroke_color;
+        brush_color.setAlpha( 150 );
+
+        painter.setPen( QPen { stroke_color, 2.0 } );
+        painter.setBrush( brush_color );
+        painter.drawPolygon( _selection_polygon );
+    }
+
+    // Render highlighted element
+    if( const auto element_index = _database.highlighted_element_index(); element_index.has_value() && xfeature && yfeature )
+    {
+        if( *element_index < xfeature->element_count() && *element_index < yfeature->element_count() )
+        {
+            const auto screen = this->world_to_screen( QPointF { xfeature->value( *element_index ), yfeature->value( *element_index ) } );
+            painter.setPen( QPen { QColor { config::palette[900] }, 1.5 } );
+            painter.setBrush( Qt::NoBrush );
+            painter.drawEllipse( screen, 5.0, 5.0 );
+        }
+    }
+
+    // Render hovered cell information
+    const auto world = this->screen_to_world( _cursor_position );
+    if( const auto cell_index = _histogram.cell_index( world.x(), world.y() ); cell_index.has_value() && _selection_polygon.empty() && content_rectangle.contains( _cursor_position.toPoint() ) )
+    {
+        const auto resolution = _histogram.resolution();
+        const auto column = *cell_index % resolution;
+        const auto row = *cell_index / resolution;
+        const auto xsize = ( xrange.upper - xrange.lower ) / resolution;
+        const auto ysize = ( yrange.upper - yrange.lower ) / resolution;
+        const auto xprecision = utility::stepsize_to_precision( xsize ) + 1;
+        const auto yprecision = utility::stepsize_to_precision( ysize ) + 1;
+
+        const auto count = _histogram.total_counts()[*cell_index];
+        const auto percentage = count / static_cast<double>( std::max( xfeature ? xfeature->element_count() : 0u, 1u ) );
+
+        auto labels_string = QString { "X:\nY:\nCount:" };
+        auto values_string = QString::number( xrange.lower + column * xsize, 'f', xprecision ) + " to " + QString::number( xrange.lower + ( column + 1 ) * xsize, 'f', xprecision )
+            + '\n' + QString::number( yrange.lower + row * ysize, 'f', yprecision ) + " to " + QString::number( yrange.lower + ( row + 1 ) * ysize, 'f', yprecision )
+            + '\n' + QString::number( count ) + " (" + QString::number( 100.0 * percentage, 'f', 1 ) + " %)";
+
+        auto labels_rectangle = painter.fontMetrics().boundingRect( QRect { 0, 0, 10000, 10000 }, Qt::TextWordWrap, labels_string ).toRectF();
+        auto values_rectangle = painter.fontMetrics().boundingRect( QRect { 0, 0, 10000, 10000 }, Qt::TextWordWrap, values_string ).toRectF();
+
+        values_rectangle.moveTopRight( content_rectangle.topRight() + QPointF { -10.0, 10.0 } );
+        labels_rectangle.moveRight( values_rectangle.left() - 10.0 );
+        labels_rectangle.moveTop( values_rectangle.top() );
+
+        auto background_rectangle = labels_rectangle.united( values_rectangle ).marginsAdded( QMarginsF { 5.0, 5.0, 5.0, 5.0 } );
+
+        painter.setPen( Qt::NoPen );
+        painter.setBrush( QBrush { QColor { 255, 255, 255, 200 } } );
+        painter.drawRoundedRect( background_rectangle, 5.0, 5.0 );
+
+        painter.setPen( Qt::black );
+        painter.drawText( labels_rectangle, Qt::AlignLeft | Qt::AlignTop, labels_string );
+        painter.drawText( values_rectangle, Qt::AlignRight | Qt::AlignTop, values_string );
+    }
+
+    painter.setClipRect( this->rect() );
+
+    // Render current features
+    if( xfeature && yfeature )
+    {
+        const auto string = yfeature->identifier() + " vs. " + xfeature->identifier();
+
+        painter.save();
+        auto font = painter.font();
+        font.setBold( true );
+        painter.setFont( font );
+
+        auto rectangle = painter.fontMetrics().boundingRect( string ).toRectF().marginsAdded( QMarginsF { 5.0, 2.0, 5.0, 2.0 } );
+        rectangle.moveCenter( content_rectangle.center() );
+        rectangle.moveTop( content_rectangle.top() );
+
+        painter.setPen( Qt::NoPen );
+        painter.setBrush( QBrush { QColor { 255, 255, 255, 200 } } );
+        painter.drawRoundedRect( rectangle, 2.0, 2.0 );
+
+        painter.setPen( Qt::black );
+        painter.drawText( rectangle, Qt::AlignCenter, string );
+
+        painter.restore();
+    }
+
+    PlottingWidget::paintEvent( event );
+}
+
+void ScatterViewer::mousePressEvent( QMouseEvent* event )
+{
+    if( event->button() == Qt::LeftButton )
+    {
+        _selection_polygon.append( event->position() );
+        _selection_mode = InteractionMode::eGrowSegment;
+    }
+    else if( event->button() == Qt::RightButton )
+    {
+        _selection_polygon.append( event->position() );
+        _selection_mode = InteractionMode::eShrinkSegment;
+    }
+}
+void ScatterViewer::mouseReleaseEvent( QMouseEvent* event )
+{
+    if( event->button() == Qt::LeftButton || event->button() == Qt::RightButton )
+    {
+        if( _selection_polygon.size() == 1 )
+        {
+            if( event->button() == Qt::RightButton )
+            {
+                auto context_menu = QMenu { this };
+
+                _database.populate_segmentation_menu( context_menu );
+                context_menu.addSeparator();
+
+                auto spinbox_resolution = new QSpinBox {};
+                spinbox_resolution->setRange( 16, 1024 );
+                spinbox_resolution->setValue( _histogram.resolution() );
+                spinbox_resolution->setSuffix( " bins per axis" );
+                QObject::connect( spinbox_resolution, qOverload<int>( &QSpinBox::valueChanged ), &_histogram, &Histogram2D::update_resolution );
+
+                auto widget_action = new QWidgetAction { &context_menu };
+                widget_action->setDefaultWidget( spinbox_resolution );
+                context_menu.addAction( widget_action );
+
+                auto logarithmic_action = context_menu.addAction( "Logarithmic Density", [this] ( bool checked )
+                {
+                    _histogram.update_logarithmic( checked );
+                } );
+                logarithmic_action->setCheckable( true );
+                logarithmic_action->setChecked( _histogram.logarithmic() );
+
+                const auto populate_feature_menu = [this] ( QMenu* menu, QSharedPointer<const Feature> current, auto update_feature )
+                {
+                    const auto features = _database.features();
+                    auto action_group = new QActionGroup { menu };
+                    action_group->setExclusive( true );
+
+                    for( qsizetype feature_index = 0; feature_index < features->object_count(); ++feature_index )
+                    {
+                        const auto feature = features->object( feature_index );
+                        auto action = menu->addAction( feature->identifier(), [this, feature, update_feature]
+                        {
+                            ( this->*update_feature )( feature );
+                        } );
+                        action->setCheckable( true );
+                        action->setChecked( feature == current );
+                        action_group->addAction( action );
+                    }
+                };
+                populate_feature_menu( context_menu.addMenu( "Change X Feature" ), _histogram.xfeature(), &ScatterViewer::update_xfeature );
+                populate_feature_menu( context_menu.addMenu( "Change Y Feature" ), _histogram.yfeature(), &ScatterViewer::update_yfeature );
+
+                context_menu.addAction( "Feature Manager", [this] { FeatureManager::execute( _database ); } );
+                this->populate_context_menu( context_menu );
+
+                context_menu.exec( event->globalPosition().toPoint() );
+            }
+        }
+        else if( _selection_polygon.size() > 2 )
+        {
+            const auto segment_number = _selection_mode == InteractionMode::eGrowSegment ? _database.active_segment()->number() : 0;
+            this->apply_selection_polygon( segment_number );
+        }
+
+        _selection_polygon.clear();
+        _selection_mode = InteractionMode::eNone;
+    }
+
+    this->update();
+}
+void ScatterViewer::mouseMoveEvent( QMouseEvent* event )
+{
+    if( event->buttons() & ( Qt::LeftButton | Qt::RightButton ) )
+    {
+        if( _selection_mode == InteractionMode::eGrowSegment || _selection_mode == InteractionMode::eShrinkSegment )
+        {
+            _selection_polygon.append( event->position() );
+        }
+    }
+
+    _cursor_position = event->position();
+    this->update();
+}
+void ScatterViewer::leaveEvent( QEvent* event )
+{
+    _cursor_position = QPointF { -1.0, -1.0 };
+    this->update();
+}
+
+void ScatterViewer::update_axes()
+{
+    const auto update_axis = [] ( Range<double> range, auto&& update_bounds, auto&& update_domain )
+    {
+        const auto margin = 0.01 * ( range.upper - range.lower );
+        update_bounds( vec2<double> { range.lower - margin, range.upper + margin } );
+        update_domain( vec2<double> { range.lower - margin, range.upper + margin } );
+    };
+
+    update_axis( _histogram.xrange(),
+        [this] ( vec2<double> bounds ) { this->update_xaxis_bounds( bounds ); },
+        [this] ( vec2<double> domain ) { this->update_xaxis_domain( domain ); }
+    );
+    update_axis( _histogram.yrange(),
+        [this] ( vec2<double> bounds ) { this->update_yaxis_bounds( bounds ); },
+        [this] ( vec2<double> domain ) { this->update_yaxis_domain( domain ); }
+    );
+    this->update();
+}
+QImage ScatterViewer::compute_image() const
+{
+    Console::info( "ScatterViewer::compute_image" );
+    const auto resolution = _histogram.resolution();
+    const auto& counts = _histogram.counts();
+    const auto& total_counts = _histogram.total_counts();
+    const auto& densities = _histogram.densities();
+
+    const auto cell_count = size_t { resolution } * resolution;
+    const auto segment_count = static_cast<uint32_t>( counts.size() / cell_count );
+    const auto segmentation = _database.segmentation();
+
+    // Segment 0 (and unsegmented data) is drawn in gray, other segments contribute their color by count
+    auto segment_colors = std::vector<vec4<float>>( segment_count, vec4<float> { 0.46f, 0.46f, 0.46f, 1.0f } );
+    for( uint32_t segment_number = 1; segment_number < segment_count && segment_number < segmentation->segment_count(); ++segment_number )
+    {
+        segment_colors[segment_number] = segmentation->segment( segment_number )->color();
+    }
+
+    auto image = QImage { static_cast<int>( resolution ), static_cast<int>( resolution ), QImage::Format_ARGB32 };
+    const auto bits = image.bits();
+    const auto bytes_per_line = static_cast<size_t>( image.bytesPerLine() );
+    utility::iterate_parallel( resolution, [&] ( uint32_t row )
+    {
+        auto scanline = reinterpret_cast<QRgb*>( bits + ( resolution - 1 - row ) * bytes_per_line );
+        for( uint32_t column = 0; column < resolution; ++column )
+        {
+            const auto cell_index = row * resolution + column;
+            if( total_counts[cell_index] == 0 )
+            {
+                scanline[column] = qRgba( 0, 0, 0, 0 );
+                continue;
+            }
+
+            auto color = vec4<float> { 0.0f, 0.0f, 0.0f, 0.0f };
+            for( uint32_t segment_number = 0; segment_number < segment_count; ++segment_number )
+            {
+                color = color + segment_colors[segment_number] * static_cast<float>( counts[segment_number * cell_count + cell_index] );
+            }
+            color = color / static_cast<float>( total_counts[cell_index] );
+
+            const auto alpha = 0.15f + 0.85f * densities[cell_index];
+            scanline[column] = qRgba(
+                static_cast<int>( color.x * 255.0f ),
+                static_cast<int>( color.y * 255.0f ),
+                static_cast<int>( color.z * 255.0f ),
+                static_cast<int>( alpha * 255.0f )
+            );
+        }
+    } );
+
+    return image;
+}
+void ScatterViewer::apply_selection_polygon( uint32_t segment_number )
+{
+    const auto xfeature = _histogram.xfeature();
+    const auto yfeature = _histogram.yfeature();
+    const auto segmentation = _database.segmentation();
+    if( !xfeature || !yfeature || xfeature->element_count() != segmentation->element_count() || yfeature->element_count() != segmentation->element_count() )
+    {
+        return;
+    }
+
+    auto polygon = QPolygonF {};
+    for( const auto& point : _selection_polygon )
+    {
+        polygon.append( this->screen_to_world( point ) );
+    }
+
+    const auto resolution = _histogram.resolution();
+    const auto xrange = _histogram.xrange();
+    const auto yrange = _histogram.yrange();
+    const auto xsize = ( xrange.upper - xrange.lower ) / resolution;
+    const auto ysize = ( yrange.upper - yrange.lower ) / resolution;
+
+    // Cells touched by the polygon outline are boundary cells whose elements are tested individually, all other cells lie entirely inside or outside
+    enum CellState : uint8_t { eOutside, eInside, eBoundary };
+
+    auto corners = std::vector<uint8_t>( size_t { resolution + 1 } * ( resolution + 1 ) );
+    utility::iterate_parallel( resolution + 1, [&] ( uint32_t row )
+    {
+        for( uint32_t column = 0; column <= resolution; ++column )
+        {
+            const auto corner = QPointF { xrange.lower + column * xsize, yrange.lower + row * ysize };
+            corners[row * ( resolution + 1 ) + column] = polygon.containsPoint( corner, Qt::OddEvenFill );
+        }
+    } );
+
+    auto cell_states = std::vector<CellState>( size_t { resolution } * resolution );
+    for( uint32_t row = 0; row < resolution; ++row )
+    {
+        for( uint32_t column = 0; column < resolution; ++column )
+        {
+            const auto corner_index = row * ( resolution + 1 ) + column;
+            const auto inside = corners[corner_index] + corners[corner_index + 1] + corners[corner_index + resolution + 1] + corners[corner_index + resolution + 2];
+            cell_states[row * resolution + column] = inside == 0 ? eOutside : inside == 4 ? eInside : eBoundary;
+        }
+    }
+
+    // Edges are clipped to the grid and traversed cell by cell, passing exactly through a corner also marks both cells beside the corner
+    const auto mark_edge = [&] ( QPointF a, QPointF b )
+    {
+        const auto u = ( a.x() - xrange.lower ) / xsize;
+        const auto v = ( a.y() - yrange.lower ) / ysize;
+        const auto du = ( b.x() - xrange.lower ) / xsize - u;
+        const auto dv = ( b.y() - yrange.lower ) / ysize - v;
+
+        auto t0 = 0.0;
+        auto t1 = 1.0;
+        const auto clip = [&] ( double p, double q )
+        {
+            if( p == 0.0 ) return q >= 0.0;
+            const auto t = q / p;
+            if( p < 0.0 ) t0 = std::max( t0, t );
+            else t1 = std::min( t1, t );
+            return t0 <= t1;
+        };
+        if( !clip( -du, u ) || !clip( du, resolution - u ) || !clip( -dv, v ) || !clip( dv, resolution - v ) )
+        {
+            return;
+        }
+
+        const auto start_u = u + t0 * du;
+        const auto start_v = v + t0 * dv;
+        const auto length_u = ( t1 - t0 ) * du;
+        const auto length_v = ( t1 - t0 ) * dv;
+
+        const auto cell = [resolution] ( double position ) { return static_cast<int64_t>( std::clamp( std::floor( position ), 0.0, resolution - 1.0 ) ); };
+        const auto mark = [&] ( int64_t column, int64_t row )
+        {
+            if( column >= 0 && column < resolution && row >= 0 && row < resolution )
+            {
+                cell_states[row * resolution + column] = eBoundary;
+            }
+        };
+
+        auto column = cell( start_u );
+        auto row = cell( start_v );
+        const auto end_column = cell( start_u + length_u );
+        const auto end_row = cell( start_v + length_v );
+        const auto step_column = length_u > 0.0 ? 1 : -1;
+        const auto step_row = length_v > 0.0 ? 1 : -1;
+
+        constexpr auto infinity = std::numeric_limits<double>::infinity();
+        const auto delta_u = length_u != 0.0 ? 1.0 / std::abs( length_u ) : infinity;
+        const auto delta_v = length_v != 0.0 ? 1.0 / std::abs( length_v ) : infinity;
+        auto next_u = length_u != 0.0 ? ( length_u > 0.0 ? column + 1 - start_u : start_u - column ) * delta_u : infinity;
+        auto next_v = length_v != 0.0 ? ( length_v > 0.0 ? row + 1 - start_v : start_v - row ) * delta_v : infinity;
+        constexpr auto corner_tolerance = 1e-9;
+
+        mark( column, row );
+        for( uint32_t step = 0; ( column != end_column || row != end_row ) && step <= 2 * resolution; ++step )
+        {
+            if( next_u < next_v - corner_tolerance )
+            {
+                column += step_column;
+                next_u += delta_u;
+            }
+            else if( next_v < next_u - corner_tolerance )
+            {
+                row += step_row;
+                next_v += delta_v;
+            }
+            else
+            {
+                mark( column + step_column, row );
+                mark( column, row + step_row );
+                column += step_column;
+                row += step_row;
+                next_u += delta_u;
+                next_v += delta_v;
+            }
+            mark( column, row );
+        }
+        mark( end_column, end_row );
+    };
+    for( qsizetype i = 0; i < polygon.size(); ++i )
+    {
+        mark_edge( polygon[i], polygon[( i + 1 ) % polygon.size()] );
+    }
+
+    const auto upper = static_cast<double>( resolution - 1 );
+    auto editor = _database.segmentation()->editor();
+    std::visit( [&] ( const auto& xvalues, const auto& yvalues )
+    {
+        for( uint32_t element_index = 0; element_index < segmentation->element_count(); ++element_index )
+        {
+            const auto x = static_cast<double>( xvalues[element_index] );
+            const auto y = static_cast<double>( yvalues[element_index] );
+            const auto column = static_cast<uint32_t>( std::clamp( ( x - xrange.lower ) / xsize, 0.0, upper ) );
+            const auto row = static_cast<uint32_t>( std::clamp( ( y - yrange.lower ) / ysize, 0.0, upper ) );
+
+            const auto state = cell_states[row * resolution + column];
+            if( state == eInside || ( state == eBoundary && polygon.containsPoint( QPointF { x, y }, Qt::OddEvenFill ) ) )
+            {
+                editor.update_value( element_index, segment_number );
+            }
+        }
+    }, xfeature->values(), yfeature->values() );
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include "database.hpp"
+#include "histogram.hpp"
+#include "plotting_widget.hpp"
+
+#include <qimage.h>
+
+class ScatterViewer : public PlottingWidget
+{
+    Q_OBJECT
+public:
+    enum class InteractionMode
+    {
+        eNone,
+        eGrowSegment,
+        eShrinkSegment
+    };
+
+    ScatterViewer( Database& database );
+
+    QSharedPointer<const Feature> xfeature() const;
+    void update_xfeature( QSharedPointer<const Feature> feature );
+
+    QSharedPointer<const Feature> yfeature() const;
+    void update_yfeature( QSharedPointer<const Feature> feature );
+
+    void paintEvent( QPaintEvent* event ) override;
+
+    void mousePressEvent( QMouseEvent* event ) override;
+    void mouseReleaseEvent( QMouseEvent* event ) override;
+    void mouseMoveEvent( QMouseEvent* event ) override;
+    void leaveEvent( QEvent* event ) override;
+
+private:
+    void update_axes();
+    QImage compute_image() const;
+    void apply_selection_polygon( uint32_t segment_number );
+
+    Database& _database;
+    Histogram2D _histogram { 256 };
+    Computed<QImage> _image;
+    CacheResidency _xfeature_residency;
+    CacheResidency _yfeature_residency;
+
+    QPointF _cursor_position;
+    QPolygonF _selection_polygon;
+    InteractionMode _selection_mode = InteractionMode::eNone;
+};
\ No newline at end of file
@@ -0,0 +1,244 @@
+#include "segment_mask.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+// ----- SegmentMask::Container ----- //
+
+bool SegmentMask::Container::bitmap() const noexcept
+{
+    return !words.empty();
+}
+std::vector<uint64_t> SegmentMask::Container::to_words() const
+{
+    if( this->bitmap() )
+    {
+        return words;
+    }
+
+    auto words = std::vector<uint64_t>( bitmap_words, 0 );
+    for( const auto value : values )
+    {
+        words[value / 64] |= uint64_t { 1 } << ( value % 64 );
+    }
+    return words;
+}
+SegmentMask::Container SegmentMask::Container::from_words( uint16_t key, std::vector<uint64_t> words )
+{
+    auto cardinality = uint32_t { 0 };
+    for( const auto word : words )
+    {
+        cardinality += static_cast<uint32_t>( std::popcount( word ) );
+    }
+
+    if( cardinality > array_capacity )
+    {
+        return Container { key, cardinality, {}, std::move( words ) };
+    }
+
+    auto values = std::vector<uint16_t> {};
+    values.reserve( cardinality );
+    for( uint32_t word = 0; word < bitmap_words; ++word )
+    {
+        for( auto bits = words[word]; bits; bits &= bits - 1 )
+        {
+            values.push_back( static_cast<uint16_t>( word * 64 + std::countr_zero( bits ) ) );
+        }
+    }
+    return Container { key, cardinality, std::move( values ), {} };
+}
+SegmentMask::Container SegmentMask::Container::from_values( uint16_t key, std::vector<uint16_t> values )
+{
+    if( values.size() > array_capacity )
+    {
+        auto container = Container { key, 0, std::move( values ), {} };
+        return Container::from_words( key, container.to_words() );
+    }
+    const auto cardinality = static_cast<uint32_t>( values.size() );
+    return Container { key, cardinality, std::move( values ), {} };
+}
+
+// ----- SegmentMask ----- //
+
+SegmentMask SegmentMask::from_indices( std::span<const uint32_t> sorted_indices )
+{
+    auto mask = SegmentMask {};
+    for( size_t begin = 0; begin < sorted_indices.size(); )
+    {
+        const auto key = static_cast<uint16_t>( sorted_indices[begin] >> 16 );
+        auto end = begin;
+
+        auto values = std::vector<uint16_t> {};
+        while( end < sorted_indices.size() && ( sorted_indices[end] >> 16 ) == key )
+        {
+            values.push_back( static_cast<uint16_t>( sorted_indices[end++] ) );
+        }
+
+        mask._containers.push_back( Container::from_values( key, std::move( values ) ) );
+        begin = end;
+    }
+    return mask;
+}
+SegmentMask SegmentMask::full( uint32_t size )
+{
+    return SegmentMask {}.complement( size );
+}
+
+uint64_t SegmentMask::cardinality() const noexcept
+{
+    auto cardinality = uint64_t { 0 };
+    for( const auto& container : _containers )
+    {
+        cardinality += container.cardinality;
+    }
+    return cardinality;
+}
+bool SegmentMask::empty() const noexcept
+{
+    return _containers.empty();
+}
+bool SegmentMask::contains( uint32_t index ) const
+{
+    const auto key = static_cast<uint16_t>( index >> 16 );
+    const auto value = static_cast<uint16_t>( index );
+
+    const auto container = std::lower_bound( _containers.begin(), _containers.end(), key, [] ( const Container& container, uint16_t key ) { return container.key < key; } );
+    if( container == _containers.end() || container->key != key )
+    {
+        return false;
+    }
+    if( container->bitmap() )
+    {
+        return ( container->words[value / 64] >> ( value % 64 ) ) & 1;
+    }
+    return std::binary_search( container->values.begin(), container->values.end(), value );
+}
+size_t SegmentMask::bytes() const noexcept
+{
+    auto bytes = _containers.capacity() * sizeof( Container );
+    for( const auto& container : _containers )
+    {
+        bytes += container.values.capacity() * sizeof( uint16_t ) + container.words.capacity() * sizeof( uint64_t );
+    }
+    return bytes;
+}
+
+SegmentMask SegmentMask::operator|( const SegmentMask& other ) const
+{
+    return this->combine( other, Operation::eUnion );
+}
+SegmentMask SegmentMask::operator&( const SegmentMask& other ) const
+{
+    return this->combine( other, Operation::eIntersection );
+}
+SegmentMask SegmentMask::operator-( const SegmentMask& other ) const
+{
+    return this->combine( other, Operation::eDifference );
+}
+SegmentMask SegmentMask::complement( uint32_t size ) const
+{
+    auto mask = SegmentMask {};
+    if( size == 0 )
+    {
+        return mask;
+    }
+
+    auto current = _containers.begin();
+    const auto last_key = ( size - 1 ) >> 16;
+    for( uint32_t key = 0; key <= last_key; ++key )
+    {
+        // Bits beyond the size are cleared in the last partition
+        const auto limit = key == last_key ? ( ( size - 1 ) & 0xFFFF ) + 1 : uint32_t { 1 } << 16;
+
+        auto words = std::vector<uint64_t>( bitmap_words, ~uint64_t { 0 } );
+        if( current != _containers.end() && current->key == key )
+        {
+            words = current->to_words();
+            for( auto& word : words )
+            {
+                word = ~word;
+            }
+            ++current;
+        }
+        for( auto bit = limit; bit < ( uint32_t { 1 } << 16 ); bit += 64 - bit % 64 )
+        {
+            words[bit / 64] &= bit % 64 ? ( uint64_t { 1 } << ( bit % 64 ) ) - 1 : 0;
+        }
+
+        auto container = Container::from_words( static_cast<uint16_t>( key ), std::move( words ) );
+        if( container.cardinality )
+        {
+            mask._containers.push_back( std::move( container ) );
+        }
+    }
+    return mask;
+}
+
+std::vector<uint32_t> SegmentMask::indices() const
+{
+    auto indices = std::vector<uint32_t> {};
+    indices.reserve( this->cardinality() );
+    this->for_each( [&indices] ( uint32_t index ) { indices.push_back( index ); } );
+    return indices;
+}
+
+SegmentMask::Container SegmentMask::combine( const Container& first, const Container& second, Operation operation )
+{
+    // Sparse partitions are merged as sorted arrays, any dense operand switches to word-wise operations
+    if( !first.bitmap() && !second.bitmap() )
+    {
+        auto values = std::vector<uint16_t> {};
+        if( operation == Operation::eUnion )
+        {
+            std::set_union( first.values.begin(), first.values.end(), second.values.begin(), second.values.end(), std::back_inserter( values ) );
+        }
+        else if( operation == Operation::eIntersection )
+        {
+            std::set_intersection( first.values.begin(), first.values.end(), second.values.begin(), second.values.end(), std::back_inserter( values ) );
+        }
+        else
+        {
+            std::set_difference( first.values.begin(), first.values.end(), second.values.begin(), second.values.end(), std::back_inserter( values ) );
+        }
+        return Container::from_values( first.key, std::move( values ) );
+    }
+
+    auto words = first.to_words();
+    const auto other_words = second.to_words();
+    for( uint32_t word = 0; word < bitmap_words; ++word )
+    {
+        if( operation == Operation::eUnion ) words[word] |= other_words[word];
+        else if( operation == Operation::eIntersection ) words[word] &= other_words[word];
+        else words[word] &= ~other_words[word];
+    }
+    return Container::from_words( first.key, std::move( words ) );
+}
+SegmentMask SegmentMask::combine( const SegmentMask& other, Operation operation ) const
+{
+    auto mask = SegmentMask {};
+    auto first = _containers.begin();
+    auto second = other._containers.begin();
+
+    while( first != _containers.end() || second != other._containers.end() )
+    {
+        if( second == other._containers.end() || ( first != _containers.end() && first->key < second->key ) )
+        {
+            if( operation != Operation::eIntersection ) mask._containers.push_back( *first );
+            ++first;
+        }
+        else if( first == _containers.end() || second->key < first->key )
+        {
+            if( operation == Operation::eUnion ) mask._containers.push_back( *second );
+            ++second;
+        }
+        else
+        {
+            auto container = SegmentMask::combine( *first++, *second++, operation );
+            if( container.cardinality )
+            {
+                mask._containers.push_back( std::move( container ) );
+            }
+        }
+    }
+    return mask;
+}
\ No newline at end of file
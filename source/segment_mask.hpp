@@ -0,0 +1,81 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// ----- SegmentMask ----- //
+
+// Roaring bitmap: indices are partitioned by their upper 16 bits, sparse partitions store sorted lower bits, dense ones a 2^16 bit bitmap
+class SegmentMask
+{
+public:
+    static constexpr auto array_capacity = uint32_t { 4096 };
+    static constexpr auto bitmap_words = uint32_t { 1024 };
+
+    SegmentMask() = default;
+    static SegmentMask from_indices( std::span<const uint32_t> sorted_indices );
+    static SegmentMask full( uint32_t size );
+
+    uint64_t cardinality() const noexcept;
+    bool empty() const noexcept;
+    bool contains( uint32_t index ) const;
+    size_t bytes() const noexcept;
+
+    SegmentMask operator|( const SegmentMask& other ) const;
+    SegmentMask operator&( const SegmentMask& other ) const;
+    SegmentMask operator-( const SegmentMask& other ) const;
+    SegmentMask complement( uint32_t size ) const;
+
+    void for_each( auto&& callable ) const;
+    std::vector<uint32_t> indices() const;
+
+private:
+    struct Container
+    {
+        uint16_t key = 0;
+        uint32_t cardinality = 0;
+        std::vector<uint16_t> values;
+        std::vector<uint64_t> words;
+
+        bool bitmap() const noexcept;
+        std::vector<uint64_t> to_words() const;
+        static Container from_words( uint16_t key, std::vector<uint64_t> words );
+        static Container from_values( uint16_t key, std::vector<uint16_t> values );
+    };
+
+    enum class Operation
+    {
+        eUnion,
+        eIntersection,
+        eDifference
+    };
+
+    static Container combine( const Container& first, const Container& second, Operation operation );
+    SegmentMask combine( const SegmentMask& other, Operation operation ) const;
+
+    std::vector<Container> _containers;
+};
+
+void SegmentMask::for_each( auto&& callable ) const
+{
+    for( const auto& container : _containers )
+    {
+        const auto high = uint32_t { container.key } << 16;
+        if( container.bitmap() )
+        {
+            for( uint32_t word = 0; word < bitmap_words; ++word )
+            {
+                for( auto bits = container.words[word]; bits; bits &= bits - 1 )
+                {
+                    callable( high | ( word * 64 + static_cast<uint32_t>( std::countr_zero( bits ) ) ) );
+                }
+            }
+        }
+        else for( const auto value : container.values )
+        {
+            callable( high | value );
+        }
+    }
+}
\ No newline at end of file
@@ -1,5 +1,32 @@
 #include "segmentation.hpp"
 
+#include "configuration.hpp"
+
+namespace
+{
+    // Counts the elements of every segment, fails if an element refers to a segment that does not exist
+    std::optional<std::vector<uint32_t>> count_segment_elements( const Array<uint32_t>& segment_numbers, uint32_t segment_count )
+    {
+        if( segment_count == 0 )
+        {
+            Console::error( "Invalid segment count 0" );
+            return std::nullopt;
+        }
+
+        auto element_counts = std::vector<uint32_t>( segment_count, 0 );
+        for( const auto segment_number : segment_numbers )
+        {
+            if( segment_number >= segment_count )
+            {
+                Console::error( std::format( "Invalid segment number {} (expected less than {})", segment_number, segment_count ) );
+                return std::nullopt;
+            }
+            ++element_counts[segment_number];
+        }
+        return element_counts;
+    }
+}
+
 // ----- Segment ----- //
 
 const Segmentation& Segment::segmentation() const noexcept
@@ -80,17 +107,13 @@ Segmentation::Segmentation( uint32_t element_count ) : _segment_numbers { elemen
     default_segment->update_element_count( element_count );
     _current_preset_color_index = 0;
 
-    _element_colors.initialize( std::bind( &Segmentation::compute_element_colors, this ) );
     _element_indices.initialize( std::bind( &Segmentation::compute_element_indices, this ) );
 
     QObject::connect( this, &Segmentation::segment_appended, this, [this] { emit segment_count_changed( this->segment_count() ); } );
-    QObject::connect( this, &Segmentation::segment_removed, this, [this] { emit segment_count_changed( this->segment_count() ); } );
 
-    QObject::connect( this, &Segmentation::segment_numbers_changed, &_element_colors, &ComputedObject::invalidate );
     QObject::connect( this, &Segmentation::segment_numbers_changed, &_element_indices, &ComputedObject::invalidate );
     QObject::connect( this, &Segmentation::segment_count_changed, &_element_indices, &ComputedObject::invalidate );
 
-    QObject::connect( &_element_colors, &ComputedObject::changed, this, &Segmentation::element_colors_changed );
     QObject::connect( &_element_indices, &ComputedObject::changed, this, &Segmentation::element_indices_changed );
 }
 
@@ -108,14 +131,23 @@ uint32_t Segmentation::segment_number( uint32_t element_index ) const
     return _segment_numbers[element_index];
 }
 
-const Array<vec4<float>>& Segmentation::element_colors() const noexcept
+QList<QRgb> Segmentation::palette() const
 {
-    return *_element_colors;
+    auto palette = QList<QRgb>( this->segment_count() );
+    for( uint32_t segment_number = 0; segment_number < this->segment_count(); ++segment_number )
+    {
+        palette[segment_number] = _segments[segment_number]->color().qcolor().rgba();
+    }
+    return palette;
 }
-const Array<std::vector<uint32_t>>& Segmentation::element_indices() const noexcept
+const GroupedIndices& Segmentation::element_indices() const noexcept
 {
     return *_element_indices;
 }
+SegmentMask Segmentation::segment_mask( uint32_t segment_number ) const
+{
+    return SegmentMask::from_indices( this->element_indices().group( segment_number ) );
+}
 
 uint32_t Segmentation::segment_count() const noexcept
 {
@@ -134,7 +166,6 @@ QSharedPointer<Segment> Segmentation::append_segment()
     auto segment = QSharedPointer<Segment> { new Segment { *this, this->segment_count(), 0, color } };
 
     QObject::connect( segment.data(), &Segment::identifier_changed, this, &Segmentation::segment_identifier_changed );
-    QObject::connect( segment.data(), &Segment::color_changed, &_element_colors, &ComputedObject::invalidate );
     QObject::connect( segment.data(), &Segment::color_changed, this, &Segmentation::segment_color_changed );
 
     _segments.push_back( segment );
@@ -143,36 +174,120 @@ QSharedPointer<Segment> Segmentation::append_segment()
 }
 void Segmentation::remove_segment( QSharedPointer<Segment> segment )
 {
-    const auto segment_number = segment->number();
-    if( _segments[segment_number] == segment && segment_number > 0 )
+    this->remove_segments( { segment } );
+}
+
+void Segmentation::remove_segments( const std::vector<QSharedPointer<Segment>>& segments )
+{
+    this->merge_segments( segments, _segments.front() );
+}
+void Segmentation::merge_segments( const std::vector<QSharedPointer<Segment>>& segments, const QSharedPointer<Segment>& target )
+{
+    const auto contains = [this] ( const QSharedPointer<Segment>& segment )
+    {
+        return segment && segment->number() < this->segment_count() && _segments[segment->number()] == segment;
+    };
+    if( !contains( target ) )
     {
-        auto default_segment_element_count = _segments.front()->element_count();
-        for( auto& current_segment_number : _segment_numbers )
+        return;
+    }
+
+    auto merged = std::vector<bool>( this->segment_count(), false );
+    for( const auto& segment : segments )
+    {
+        if( contains( segment ) && segment != target && segment->number() > 0 )
         {
-            if( current_segment_number == segment_number )
-            {
-                current_segment_number = 0;
-                ++default_segment_element_count;
-            }
-            else if( current_segment_number > segment_number )
-            {
-                --current_segment_number;
-            }
+            merged[segment->number()] = true;
         }
-        _segments.front()->update_element_count( default_segment_element_count );
+    }
 
-        _segments.erase( _segments.begin() + segment_number );
-        for( uint32_t i = segment_number; i < _segments.size(); ++i )
+    auto renumbering = std::vector<uint32_t>( this->segment_count() );
+    auto remaining_segments = std::vector<QSharedPointer<Segment>> {};
+    for( uint32_t segment_number = 0; segment_number < this->segment_count(); ++segment_number )
+    {
+        if( !merged[segment_number] )
         {
-            _segments[i]->update_number( i );
+            renumbering[segment_number] = static_cast<uint32_t>( remaining_segments.size() );
+            remaining_segments.push_back( _segments[segment_number] );
         }
-        emit segment_removed( segment );
+    }
+    if( remaining_segments.size() == this->segment_count() )
+    {
+        return;
+    }
 
-        if( segment->element_count() )
+    for( uint32_t segment_number = 0; segment_number < this->segment_count(); ++segment_number )
+    {
+        if( merged[segment_number] )
         {
-            emit segment_numbers_changed();
+            renumbering[segment_number] = renumbering[target->number()];
         }
     }
+    this->renumber_segments( renumbering, std::move( remaining_segments ) );
+}
+void Segmentation::compact_segments()
+{
+    auto empty_segments = std::vector<QSharedPointer<Segment>> {};
+    for( uint32_t segment_number = 1; segment_number < this->segment_count(); ++segment_number )
+    {
+        if( _segments[segment_number]->element_count() == 0 )
+        {
+            empty_segments.push_back( _segments[segment_number] );
+        }
+    }
+
+    // At least one segment besides the default segment is kept
+    if( empty_segments.size() + 1 == this->segment_count() )
+    {
+        empty_segments.erase( empty_segments.begin() );
+    }
+    this->remove_segments( empty_segments );
+}
+
+void Segmentation::assign( const Segmentation& segmentation )
+{
+    if( segmentation.element_count() != this->element_count() )
+    {
+        Console::error( std::format( "Invalid element_count {} (expected {})", segmentation.element_count(), this->element_count() ) );
+        return;
+    }
+
+    const auto previous_segment_numbers = _recording_history ? utility::compress_runs( std::span { _segment_numbers.data(), _segment_numbers.size() } ) : QByteArray {};
+    const auto previous_segment_count = this->segment_count();
+
+    while( this->segment_count() < segmentation.segment_count() )
+    {
+        this->append_segment();
+    }
+    for( uint32_t segment_number = 0; segment_number < this->segment_count(); ++segment_number )
+    {
+        if( segment_number < segmentation.segment_count() )
+        {
+            const auto& segment = segmentation.segment( segment_number );
+            _segments[segment_number]->update_identifier( segment->_identifier.override_value() );
+            _segments[segment_number]->update_color( segment->color() );
+            _segments[segment_number]->update_element_count( segment->element_count() );
+        }
+        else
+        {
+            _segments[segment_number]->update_element_count( 0 );
+        }
+    }
+
+    _current_preset_color_index = segmentation._current_preset_color_index;
+    std::copy( segmentation._segment_numbers.begin(), segmentation._segment_numbers.end(), _segment_numbers.begin() );
+
+    if( this->segment_count() > segmentation.segment_count() )
+    {
+        this->remove_segments( { _segments.begin() + segmentation.segment_count(), _segments.end() } );
+    }
+
+    // Removing segments renumbers them and clears the history, otherwise the assignment can be undone
+    if( _recording_history && this->segment_count() >= previous_segment_count )
+    {
+        this->record_history( HistoryEntry { {}, previous_segment_numbers } );
+    }
+    this->notify_segment_numbers_changed( {}, true );
 }
 
 nlohmann::json Segmentation::serialize() const
@@ -189,11 +304,8 @@ nlohmann::json Segmentation::serialize() const
         json_segments.push_back( json_segment );
     }
 
-    auto segment_numbers = nlohmann::json::array();
-    for( const auto segment_number : _segment_numbers )
-    {
-        segment_numbers.push_back( segment_number );
-    }
+    // Segment numbers are stored as base64 encoded, compressed runs
+    const auto segment_numbers = utility::compress_runs( std::span { _segment_numbers.data(), _segment_numbers.size() } ).toBase64().toStdString();
 
     auto json = nlohmann::json {};
     json["element_count"] = this->element_count();
@@ -212,43 +324,66 @@ bool Segmentation::deserialize( const nlohmann::json& json )
     }
 
     const auto segments = json.value( "segments", nlohmann::json::array() );
-    while( this->segment_count() < segments.size() )
+    const auto segment_count = static_cast<uint32_t>( segments.size() );
+
+    // Segment numbers are decoded and validated before anything is modified, so invalid input leaves the segmentation untouched
+    auto segment_numbers = Array<uint32_t> { element_count, 0 };
+    const auto& json_segment_numbers = json["segment_numbers"];
+    if( json_segment_numbers.is_string() )
     {
-        this->append_segment();
+        const auto bytes = QByteArray::fromBase64( QByteArray::fromStdString( json_segment_numbers.get<std::string>() ) );
+        if( !utility::decompress_runs( bytes, std::span { segment_numbers.data(), segment_numbers.size() } ) )
+        {
+            Console::error( "Failed to decompress segment numbers" );
+            return false;
+        }
     }
-
-    auto element_counts = std::vector<uint32_t> {};
-    for( const auto json_segment : segments )
+    else
     {
-        const auto number = json_segment["number"].get<uint32_t>();
-        const auto element_count = json_segment["element_count"].get<uint32_t>();
-        const auto identifier = QString::fromStdString( json_segment["identifier"].get<std::string>() );
-        const auto color = QColor { QString::fromStdString( json_segment["color"].get<std::string>() ) };
+        if( json_segment_numbers.size() != element_count )
+        {
+            Console::error( std::format( "Invalid segment number count {} (expected {})", json_segment_numbers.size(), element_count ) );
+            return false;
+        }
 
-        element_counts.push_back( element_count );
-        _segments[number]->update_identifier( identifier.isEmpty() ? std::nullopt : std::optional<QString> { identifier } );
-        _segments[number]->update_color( number == 0 ? vec4<float> {} : vec4<float> { color.redF(), color.greenF(), color.blueF(), color.alphaF() } );
+        auto current_index = 0;
+        for( const uint32_t segment_number : json_segment_numbers )
+        {
+            segment_numbers[current_index++] = segment_number;
+        }
     }
 
-    _current_preset_color_index = json["current_preset_color_index"].get<uint32_t>();
-    const auto segment_numbers = json["segment_numbers"];
-    auto current_index = 0;
-    for( const uint32_t segment_number : segment_numbers )
+    const auto element_counts = count_segment_elements( segment_numbers, segment_count );
+    if( !element_counts )
     {
-        _segment_numbers[current_index++] = segment_number;
+        return false;
+    }
+    for( const auto& json_segment : segments )
+    {
+        if( json_segment["number"].get<uint32_t>() >= segment_count )
+        {
+            Console::error( std::format( "Invalid segment number {}", json_segment["number"].get<uint32_t>() ) );
+            return false;
+        }
     }
 
-    for( uint32_t segment_number = 0; segment_number < element_counts.size(); ++segment_number )
+    while( this->segment_count() < segment_count )
     {
-        _segments[segment_number]->update_element_count( element_counts[segment_number] );
+        this->append_segment();
     }
 
-    while( this->segment_count() > segments.size() )
+    for( const auto json_segment : segments )
     {
-        this->remove_segment( _segments.back() );
+        const auto number = json_segment["number"].get<uint32_t>();
+        const auto identifier = QString::fromStdString( json_segment["identifier"].get<std::string>() );
+        const auto color = QColor { QString::fromStdString( json_segment["color"].get<std::string>() ) };
+
+        _segments[number]->update_identifier( identifier.isEmpty() ? std::nullopt : std::optional<QString> { identifier } );
+        _segments[number]->update_color( number == 0 ? vec4<float> {} : vec4<float> { color.redF(), color.greenF(), color.blueF(), color.alphaF() } );
     }
 
-    emit segment_numbers_changed();
+    _current_preset_color_index = json["current_preset_color_index"].get<uint32_t>();
+    this->restore_segment_numbers( segment_numbers, *element_counts );
     return true;
 }
 
@@ -270,7 +405,15 @@ void Segmentation::serialize( MIAFileStream& stream ) const
     }
 
     stream.write( _current_preset_color_index );
-    stream.write( _segment_numbers.data(), _segment_numbers.size() * sizeof( uint32_t ) );
+
+    // Segment numbers are written as compressed runs in blocks, bounding the memory of each encoding step
+    for( size_t offset = 0; offset < _segment_numbers.size(); offset += config::segmentation_block_size )
+    {
+        const auto count = std::min<size_t>( config::segmentation_block_size, _segment_numbers.size() - offset );
+        const auto bytes = utility::compress_runs( std::span { _segment_numbers.data() + offset, count } );
+        stream.write( static_cast<uint64_t>( bytes.size() ) );
+        stream.write( bytes.constData(), static_cast<size_t>( bytes.size() ) );
+    }
 }
 bool Segmentation::deserialize( MIAFileStream& stream )
 {
@@ -281,40 +424,100 @@ bool Segmentation::deserialize( MIAFileStream& stream )
         return false;
     }
 
+    struct SegmentRecord
+    {
+        uint32_t number;
+        QString identifier;
+        QColor color;
+    };
+
     const auto segment_count = stream.read<uint32_t>();
+    auto segment_records = std::vector<SegmentRecord>( segment_count );
+    for( auto& segment_record : segment_records )
+    {
+        segment_record.number = stream.read<uint32_t>();
+        stream.read<uint32_t>();
+        segment_record.identifier = QString::fromStdString( stream.read<std::string>() );
+        segment_record.color = QColor { QString::fromStdString( stream.read<std::string>() ) };
+
+        if( segment_record.number >= segment_count )
+        {
+            Console::error( std::format( "Invalid segment number {}", segment_record.number ) );
+            return false;
+        }
+    }
+
+    const auto current_preset_color_index = stream.read<uint32_t>();
+
+    // Segment numbers are decoded and validated before anything is modified, so invalid input leaves the segmentation untouched
+    auto segment_numbers = Array<uint32_t> { element_count, 0 };
+    if( stream.application_version() >= config::ApplicationVersion { 1, 0, 7 } )
+    {
+        auto bytes = QByteArray {};
+        for( size_t offset = 0; offset < segment_numbers.size(); offset += config::segmentation_block_size )
+        {
+            const auto count = std::min<size_t>( config::segmentation_block_size, segment_numbers.size() - offset );
+            bytes.resize( static_cast<qsizetype>( stream.read<uint64_t>() ) );
+            stream.read( bytes.data(), static_cast<size_t>( bytes.size() ) );
+            if( !utility::decompress_runs( bytes, std::span { segment_numbers.data() + offset, count } ) )
+            {
+                Console::error( "Failed to decompress segment numbers" );
+                return false;
+            }
+        }
+    }
+    else
+    {
+        stream.read( segment_numbers.data(), segment_numbers.size() * sizeof( uint32_t ) );
+    }
+
+    const auto element_counts = count_segment_elements( segment_numbers, segment_count );
+    if( !element_counts )
+    {
+        return false;
+    }
+
     while( this->segment_count() < segment_count )
     {
         this->append_segment();
     }
 
-    auto element_counts = std::vector<uint32_t>( segment_count );
-    for( uint32_t i = 0; i < segment_count; ++i )
+    for( const auto& segment_record : segment_records )
     {
-        const auto segment_number = stream.read<uint32_t>();
-        const auto element_count = stream.read<uint32_t>();
-        const auto segment_identifier = QString::fromStdString( stream.read<std::string>() );
-        const auto segment_color = QColor { QString::fromStdString( stream.read<std::string>() ) };
-
-        element_counts[i] = element_count;
-        _segments[segment_number]->update_identifier( segment_identifier.isEmpty() ? std::nullopt : std::optional<QString> { segment_identifier } );
-        _segments[segment_number]->update_color( segment_number == 0 ? vec4<float> {} : vec4<float> { segment_color.redF(), segment_color.greenF(), segment_color.blueF(), segment_color.alphaF() } );
+        const auto& color = segment_record.color;
+        _segments[segment_record.number]->update_identifier( segment_record.identifier.isEmpty() ? std::nullopt : std::optional<QString> { segment_record.identifier } );
+        _segments[segment_record.number]->update_color( segment_record.number == 0 ? vec4<float> {} : vec4<float> { color.redF(), color.greenF(), color.blueF(), color.alphaF() } );
     }
 
-    _current_preset_color_index = stream.read<uint32_t>();
-    stream.read( _segment_numbers.data(), _segment_numbers.size() * sizeof( uint32_t ) );
+    _current_preset_color_index = current_preset_color_index;
+    this->restore_segment_numbers( segment_numbers, *element_counts );
+    return true;
+}
 
-    for( uint32_t segment_number = 0; segment_number < segment_count; ++segment_number )
+void Segmentation::restore_segment_numbers( const Array<uint32_t>& segment_numbers, const std::vector<uint32_t>& element_counts )
+{
+    std::copy( segment_numbers.begin(), segment_numbers.end(), _segment_numbers.begin() );
+    for( uint32_t segment_number = 0; segment_number < element_counts.size(); ++segment_number )
     {
         _segments[segment_number]->update_element_count( element_counts[segment_number] );
     }
 
-    while( this->segment_count() > segment_count )
+    if( this->segment_count() > element_counts.size() )
     {
-        this->remove_segment( _segments.back() );
+        this->remove_segments( { _segments.begin() + element_counts.size(), _segments.end() } );
     }
 
-    emit segment_numbers_changed();
-    return true;
+    this->clear_history();
+    this->notify_segment_numbers_changed( {}, true );
+}
+
+const std::vector<Segmentation::Change>& Segmentation::changes() const noexcept
+{
+    return _changes;
+}
+bool Segmentation::full_change() const noexcept
+{
+    return _full_change;
 }
 
 Segmentation::Editor Segmentation::editor()
@@ -322,29 +525,289 @@ Segmentation::Editor Segmentation::editor()
     return Editor { *this };
 }
 
-Array<vec4<float>> Segmentation::compute_element_colors() const
+bool Segmentation::undoable() const noexcept
+{
+    return !_undo_history.empty();
+}
+bool Segmentation::redoable() const noexcept
+{
+    return !_redo_history.empty();
+}
+void Segmentation::undo()
+{
+    _history_group_entry = false;
+    if( !_undo_history.empty() )
+    {
+        auto entry = std::move( _undo_history.back() );
+        _undo_history.pop_back();
+        _history_bytes -= entry.bytes();
+
+        entry = this->restore_history( std::move( entry ), true );
+        _history_bytes += entry.bytes();
+        _redo_history.push_back( std::move( entry ) );
+        this->trim_history();
+    }
+}
+void Segmentation::redo()
+{
+    _history_group_entry = false;
+    if( !_redo_history.empty() )
+    {
+        auto entry = std::move( _redo_history.back() );
+        _redo_history.pop_back();
+        _history_bytes -= entry.bytes();
+
+        entry = this->restore_history( std::move( entry ), false );
+        _history_bytes += entry.bytes();
+        _undo_history.push_back( std::move( entry ) );
+        this->trim_history();
+    }
+}
+void Segmentation::clear_history()
+{
+    _undo_history.clear();
+    _redo_history.clear();
+    _history_bytes = 0;
+    _history_group_entry = false;
+}
+void Segmentation::begin_history_group()
+{
+    ++_history_group_depth;
+}
+void Segmentation::end_history_group()
 {
-    auto element_colors = Array<vec4<float>>::allocate( this->element_count() );
+    if( _history_group_depth && --_history_group_depth == 0 )
+    {
+        _history_group_entry = false;
+
+        if( std::exchange( _history_group_changed, false ) )
+        {
+            this->emit_segment_numbers_changed( std::exchange( _history_group_changes, {} ), std::exchange( _history_group_full_change, false ) );
+        }
+    }
+}
+
+size_t Segmentation::HistoryEntry::bytes() const noexcept
+{
+    return changes.size() * sizeof( Change ) + static_cast<size_t>( segment_numbers.size() );
+}
 
-    utility::iterate_parallel( this->element_count(), [&] ( uint32_t element_index )
+void Segmentation::notify_segment_numbers_changed( std::vector<Change> changes, bool full_change )
+{
+    _full_change = full_change;
+    _changes = std::move( changes );
+    emit segment_numbers_edited();
+
+    if( _history_group_depth == 0 )
     {
-        const auto segment_number = _segment_numbers[element_index];
-        element_colors[element_index] = this->segment( segment_number )->color();
-    } );
+        emit segment_numbers_changed();
+    }
+    else
+    {
+        // The logs of a group are replayed in order, so an element edited twice appears twice
+        _history_group_changed = true;
+        if( _full_change || _history_group_changes.size() + _changes.size() >= this->element_count() / 4 )
+        {
+            _history_group_full_change = true;
+        }
+        if( _history_group_full_change )
+        {
+            _history_group_changes = std::vector<Change> {};
+        }
+        else
+        {
+            _history_group_changes.insert( _history_group_changes.end(), _changes.begin(), _changes.end() );
+        }
+    }
+
+    _full_change = true;
+    _changes = std::vector<Change> {};
+}
+void Segmentation::emit_segment_numbers_changed( std::vector<Change> changes, bool full_change )
+{
+    _full_change = full_change;
+    _changes = std::move( changes );
+    emit segment_numbers_changed();
+
+    _full_change = true;
+    _changes = std::vector<Change> {};
+}
+void Segmentation::record_history( HistoryEntry entry )
+{
+    for( const auto& redo_entry : _redo_history )
+    {
+        _history_bytes -= redo_entry.bytes();
+    }
+    _redo_history.clear();
+
+    // Edits of an open history group are merged into the entry of its first edit
+    if( _history_group_entry && !_undo_history.empty() )
+    {
+        auto& group = _undo_history.back();
+        _history_bytes -= group.bytes();
+        this->merge_history( group, std::move( entry ) );
+        _history_bytes += group.bytes();
+    }
+    else
+    {
+        _history_bytes += entry.bytes();
+        _undo_history.push_back( std::move( entry ) );
+        _history_group_entry = _history_group_depth != 0;
+    }
+
+    this->trim_history();
+    if( _undo_history.empty() )
+    {
+        _history_group_entry = false;
+    }
+}
+void Segmentation::merge_history( HistoryEntry& group, HistoryEntry entry ) const
+{
+    // A snapshot already holds the segment numbers before the group
+    if( !group.segment_numbers.isEmpty() )
+    {
+        return;
+    }
+
+    if( entry.segment_numbers.isEmpty() && group.changes.size() + entry.changes.size() < this->element_count() / 4 )
+    {
+        group.changes.insert( group.changes.end(), entry.changes.begin(), entry.changes.end() );
+        return;
+    }
+
+    // Large groups become a snapshot, the segment numbers before the entry are reverted by the change log of the group
+    auto segment_numbers = _segment_numbers;
+    if( !entry.segment_numbers.isEmpty() )
+    {
+        if( !utility::decompress_runs( entry.segment_numbers, std::span { segment_numbers.data(), segment_numbers.size() } ) )
+        {
+            Console::error( "Failed to merge segmentation snapshot" );
+            return;
+        }
+    }
+    else for( auto change = entry.changes.rbegin(); change != entry.changes.rend(); ++change )
+    {
+        segment_numbers[change->element_index] = change->previous_segment_number;
+    }
 
-    return element_colors;
+    for( auto change = group.changes.rbegin(); change != group.changes.rend(); ++change )
+    {
+        segment_numbers[change->element_index] = change->previous_segment_number;
+    }
+    group = HistoryEntry { {}, utility::compress_runs( std::span { segment_numbers.data(), segment_numbers.size() } ) };
 }
-Array<std::vector<uint32_t>> Segmentation::compute_element_indices() const
+Segmentation::HistoryEntry Segmentation::restore_history( HistoryEntry entry, bool backward )
 {
-    auto element_indices = Array<std::vector<uint32_t>> { this->segment_count(), std::vector<uint32_t> {} };
+    _recording_history = false;
+
+    // Change logs are replayed in either direction, snapshots are swapped with the current segment numbers
+    if( entry.segment_numbers.isEmpty() )
+    {
+        auto editor = this->editor();
+        if( backward ) for( auto change = entry.changes.rbegin(); change != entry.changes.rend(); ++change )
+        {
+            editor.update_value( change->element_index, change->previous_segment_number );
+        }
+        else for( const auto& change : entry.changes )
+        {
+            editor.update_value( change.element_index, change.segment_number );
+        }
+    }
+    else
+    {
+        auto segment_numbers = Array<uint32_t>::allocate( this->element_count() );
+        if( !utility::decompress_runs( entry.segment_numbers, std::span { segment_numbers.data(), segment_numbers.size() } ) )
+        {
+            Console::error( "Failed to restore segmentation snapshot" );
+        }
+        else
+        {
+            entry.segment_numbers = utility::compress_runs( std::span { _segment_numbers.data(), _segment_numbers.size() } );
+
+            auto editor = this->editor();
+            for( uint32_t element_index = 0; element_index < this->element_count(); ++element_index )
+            {
+                editor.update_value( element_index, segment_numbers[element_index] );
+            }
+        }
+    }
+
+    _recording_history = true;
+    return entry;
+}
+void Segmentation::trim_history()
+{
+    // The oldest undo entries are dropped first, redo entries only when nothing else is left
+    auto dropped = 0;
+    while( _history_bytes > config::segmentation_history_budget && !_undo_history.empty() )
+    {
+        _history_bytes -= _undo_history.front().bytes();
+        _undo_history.erase( _undo_history.begin() );
+        ++dropped;
+    }
+    while( _history_bytes > config::segmentation_history_budget && !_redo_history.empty() )
+    {
+        _history_bytes -= _redo_history.front().bytes();
+        _redo_history.erase( _redo_history.begin() );
+        ++dropped;
+    }
+
+    if( dropped )
+    {
+        Console::info( std::format( "Dropped {} segmentation history entries ({} bytes remaining)", dropped, _history_bytes ) );
+    }
+}
+void Segmentation::renumber_segments( const std::vector<uint32_t>& renumbering, std::vector<QSharedPointer<Segment>> segments )
+{
+    // Element counts follow from the renumbering, only the segment numbers need a pass over all elements
+    auto element_counts = std::vector<uint32_t>( segments.size(), 0 );
+    auto removed_segments = std::vector<QSharedPointer<Segment>> {};
+    auto reassigned = false;
+    for( uint32_t segment_number = 0; segment_number < this->segment_count(); ++segment_number )
+    {
+        const auto& segment = _segments[segment_number];
+        element_counts[renumbering[segment_number]] += segment->element_count();
+
+        if( segments[renumbering[segment_number]] != segment )
+        {
+            removed_segments.push_back( segment );
+        }
+        if( renumbering[segment_number] != segment_number && segment->element_count() )
+        {
+            reassigned = true;
+        }
+    }
+
+    if( reassigned )
+    {
+        utility::iterate_parallel( this->element_count(), [&] ( uint32_t element_index )
+        {
+            _segment_numbers[element_index] = renumbering[_segment_numbers[element_index]];
+        } );
+    }
+
+    _segments = std::move( segments );
+    for( uint32_t segment_number = 0; segment_number < this->segment_count(); ++segment_number )
+    {
+        _segments[segment_number]->update_number( segment_number );
+        _segments[segment_number]->update_element_count( element_counts[segment_number] );
+    }
+    this->clear_history();
 
-    for( uint32_t element_index = 0; element_index < this->element_count(); ++element_index )
+    for( const auto& segment : removed_segments )
     {
-        const auto segment_number = _segment_numbers[element_index];
-        element_indices[segment_number].push_back( element_index );
+        emit segment_removed( segment );
     }
+    emit segment_count_changed( this->segment_count() );
 
-    return element_indices;
+    if( reassigned )
+    {
+        this->notify_segment_numbers_changed( {}, true );
+    }
+}
+GroupedIndices Segmentation::compute_element_indices() const
+{
+    return GroupedIndices::from_group_numbers( std::span { _segment_numbers.data(), _segment_numbers.size() }, this->segment_count() );
 }
 
 // ----- Segmentation::Editor ----- //
@@ -355,14 +818,54 @@ Segmentation::Editor::~Editor()
     {
         _segmentation.segment( segment_number )->update_element_count( _element_counts[segment_number] );
     }
-    emit _segmentation.segment_numbers_changed();
+
+    if( _segmentation._recording_history && ( _full_change || !_changes.empty() ) )
+    {
+        _segmentation.record_history( HistoryEntry { _full_change ? std::vector<Change> {} : _changes, std::move( _previous_segment_numbers ) } );
+    }
+    if( _full_change || !_changes.empty() )
+    {
+        _segmentation.notify_segment_numbers_changed( std::move( _changes ), _full_change );
+    }
 }
 
 void Segmentation::Editor::update_value( uint32_t element_index, uint32_t segment_number )
 {
     auto& current_segment_number = _segmentation._segment_numbers[element_index];
-    --_element_counts[current_segment_number];
-    ++_element_counts[current_segment_number = segment_number];
+    if( current_segment_number != segment_number )
+    {
+        // Large edits are cheaper to recompute than to replay, so the log is dropped beyond a quarter of the elements
+        if( !_full_change && _changes.size() < _segmentation.element_count() / 4 )
+        {
+            _changes.push_back( Change { element_index, current_segment_number, segment_number } );
+        }
+        else if( !_full_change )
+        {
+            // The segment numbers before this edit are kept as snapshot for the history
+            if( _segmentation._recording_history )
+            {
+                auto previous_segment_numbers = _segmentation._segment_numbers;
+                for( auto change = _changes.rbegin(); change != _changes.rend(); ++change )
+                {
+                    previous_segment_numbers[change->element_index] = change->previous_segment_number;
+                }
+                _previous_segment_numbers = utility::compress_runs( std::span { previous_segment_numbers.data(), previous_segment_numbers.size() } );
+            }
+
+            _full_change = true;
+            _changes = std::vector<Change> {};
+        }
+        --_element_counts[current_segment_number];
+        ++_element_counts[current_segment_number = segment_number];
+    }
+}
+
+void Segmentation::Editor::update_range( uint32_t element_index, uint32_t count, uint32_t segment_number )
+{
+    for( auto index = element_index; index < element_index + count; ++index )
+    {
+        this->update_value( index, segment_number );
+    }
 }
 
 Segmentation::Editor::Editor( Segmentation& segmentation ) : _segmentation { segmentation }, _element_counts( _segmentation.segment_count() )
@@ -1,7 +1,9 @@
 #pragma once
 #include "json.hpp"
+#include "segment_mask.hpp"
 #include "utility.hpp"
 
+#include <qlist.h>
 #include <qobject.h>
 #include <qsharedpointer.h>
 
@@ -49,6 +51,13 @@ class Segmentation : public QObject
 {
     Q_OBJECT
 public:
+    struct Change
+    {
+        uint32_t element_index;
+        uint32_t previous_segment_number;
+        uint32_t segment_number;
+    };
+
     class Editor
     {
     public:
@@ -61,6 +70,7 @@ public:
         ~Editor();
 
         void update_value( uint32_t element_index, uint32_t segment_number );
+        void update_range( uint32_t element_index, uint32_t count, uint32_t segment_number );
 
     private:
         friend class Segmentation;
@@ -69,6 +79,9 @@ public:
 
         Segmentation& _segmentation;
         std::vector<uint32_t> _element_counts;
+        std::vector<Change> _changes;
+        bool _full_change = false;
+        QByteArray _previous_segment_numbers;
     };
 
     Segmentation( uint32_t element_count );
@@ -78,8 +91,14 @@ public:
     const Array<uint32_t>& segment_numbers() const noexcept;
     uint32_t segment_number( uint32_t element_index ) const;
 
-    const Array<vec4<float>>& element_colors() const noexcept;
-    const Array<std::vector<uint32_t>>& element_indices() const noexcept;
+    // Segment colors indexed by segment number, used as color table for indexed segmentation images
+    QList<QRgb> palette() const;
+    const GroupedIndices& element_indices() const noexcept;
+    SegmentMask segment_mask( uint32_t segment_number ) const;
+
+    // Elements reassigned by the segment_numbers_edited or segment_numbers_changed currently being emitted, outside of them every change is reported as full
+    const std::vector<Change>& changes() const noexcept;
+    bool full_change() const noexcept;
 
     uint32_t segment_count() const noexcept;
     const QSharedPointer<Segment>& segment( uint32_t segment_number ) const;
@@ -87,6 +106,14 @@ public:
     QSharedPointer<Segment> append_segment();
     void remove_segment( QSharedPointer<Segment> segment );
 
+    // Bulk operations renumber all elements in a single pass, the default segment is never removed
+    void remove_segments( const std::vector<QSharedPointer<Segment>>& segments );
+    void merge_segments( const std::vector<QSharedPointer<Segment>>& segments, const QSharedPointer<Segment>& target );
+    void compact_segments();
+
+    // Copies segments and segment numbers of a segmentation with the same element count
+    void assign( const Segmentation& segmentation );
+
     nlohmann::json serialize() const;
     bool deserialize( const nlohmann::json& json );
 
@@ -95,9 +122,22 @@ public:
 
     Editor editor();
 
+    // Edits are recorded as change logs, or as compressed snapshots when the log was dropped
+    bool undoable() const noexcept;
+    bool redoable() const noexcept;
+    void undo();
+    void redo();
+    void clear_history();
+
+    // Edits between begin and end of a history group are merged into one entry, groups may be nested
+    // Within a group segment_numbers_changed is deferred to its end and reports all of its edits at once
+    void begin_history_group();
+    void end_history_group();
+
 signals:
+    // Emitted for every edit, for views that have to follow an ongoing interaction such as a brush stroke
+    void segment_numbers_edited() const;
     void segment_numbers_changed() const;
-    void element_colors_changed() const;
     void element_indices_changed() const;
 
     void segment_appended( const QSharedPointer<Segment>& segment ) const;
@@ -108,12 +148,40 @@ signals:
     void segment_color_changed() const;
 
 private:
-    Array<vec4<float>> compute_element_colors() const;
-    Array<std::vector<uint32_t>> compute_element_indices() const;
+    struct HistoryEntry
+    {
+        std::vector<Change> changes;
+        QByteArray segment_numbers;
+
+        size_t bytes() const noexcept;
+    };
+
+    void notify_segment_numbers_changed( std::vector<Change> changes, bool full_change );
+    void emit_segment_numbers_changed( std::vector<Change> changes, bool full_change );
+    void restore_segment_numbers( const Array<uint32_t>& segment_numbers, const std::vector<uint32_t>& element_counts );
+    void renumber_segments( const std::vector<uint32_t>& renumbering, std::vector<QSharedPointer<Segment>> segments );
+
+    void record_history( HistoryEntry entry );
+    void merge_history( HistoryEntry& group, HistoryEntry entry ) const;
+    HistoryEntry restore_history( HistoryEntry entry, bool backward );
+    void trim_history();
+
+    GroupedIndices compute_element_indices() const;
 
     Array<uint32_t> _segment_numbers;
-    Computed<Array<vec4<float>>> _element_colors;
-    Computed<Array<std::vector<uint32_t>>> _element_indices;
+    std::vector<Change> _changes;
+    bool _full_change = true;
+    Computed<GroupedIndices> _element_indices;
+
+    std::vector<HistoryEntry> _undo_history;
+    std::vector<HistoryEntry> _redo_history;
+    size_t _history_bytes = 0;
+    bool _recording_history = true;
+    uint32_t _history_group_depth = 0;
+    bool _history_group_entry = false;
+    bool _history_group_changed = false;
+    std::vector<Change> _history_group_changes;
+    bool _history_group_full_change = false;
 
     std::vector<QSharedPointer<Segment>> _segments;
     uint32_t _current_preset_color_index = 0;
@@ -72,7 +72,7 @@ SegmentationManager::SegmentationManager( Database& database ) : QDialog {}, _da
                 segment->update_identifier( text );
             }
         } );
-        QObject::connect( button_merge, &QToolButton::clicked, this, [this, pointer = QWeakPointer { segment }, button_merge, button_remove]
+        QObject::connect( button_merge, &QToolButton::clicked, this, [this, pointer = QWeakPointer { segment }, button_merge]
         {
             if( auto source = pointer.lock() )
             {
@@ -87,31 +87,17 @@ SegmentationManager::SegmentationManager( Database& database ) : QDialog {}, _da
                 context_menu.addAction( widget_action );
                 context_menu.addSeparator();
 
-                const auto segmentation     = _database.segmentation();
-                const auto source_number    = source->number();
-
+                const auto segmentation = _database.segmentation();
                 for( uint32_t segment_number = 1; segment_number < segmentation->segment_count(); ++segment_number )
                 {
-                    const auto target           = segmentation->segment( segment_number );
-                    const auto target_number    = target->number();
-
+                    const auto target = segmentation->segment( segment_number );
                     if( target != source )
                     {
                         auto pixmap = QPixmap { 16, 16 };
                         pixmap.fill( target->color().qcolor() );
-                        auto action = context_menu.addAction( QIcon { pixmap }, target->identifier(), [segmentation, source_number, target_number, button_remove]
+                        auto action = context_menu.addAction( QIcon { pixmap }, target->identifier(), [segmentation, source, target]
                         {
-                            {
-                                auto editor = segmentation->editor();
-                                for( uint32_t element_index = 0; element_index < segmentation->element_count(); ++element_index )
-                                {
-                                    if( segmentation->segment_number( element_index ) == source_number )
-                                    {
-                                        editor.update_value( element_index, target_number );
-                                    }
-                                }
-                            }
-                            button_remove->click();
+                            segmentation->merge_segments( { source }, target );
                         } );
                     }
                 }
@@ -172,11 +158,19 @@ SegmentationManager::SegmentationManager( Database& database ) : QDialog {}, _da
     auto button_merge_segments = new QPushButton { "Merge Segments" };
     button_merge_segments->setStyleSheet( "QPushButton { padding: 2px 10px 2px 10px; }" );
 
+    auto button_combine_segments = new QPushButton { "Combine Segments" };
+    button_combine_segments->setStyleSheet( "QPushButton { padding: 2px 10px 2px 10px; }" );
+
+    auto button_remove_empty_segments = new QPushButton { "Remove Empty Segments" };
+    button_remove_empty_segments->setStyleSheet( "QPushButton { padding: 2px 10px 2px 10px; }" );
+
     auto controls = new QHBoxLayout {};
     controls->setContentsMargins( 0, 0, 0, 0 );
     controls->setSpacing( 5 );
     controls->addWidget( button_create_segment );
     controls->addWidget( button_merge_segments );
+    controls->addWidget( button_combine_segments );
+    controls->addWidget( button_remove_empty_segments );
 
     auto layout = new QVBoxLayout { this };
     layout->setContentsMargins( 20, 10, 20, 10 );
@@ -189,6 +183,110 @@ SegmentationManager::SegmentationManager( Database& database ) : QDialog {}, _da
     {
         _database.update_active_segment( _database.segmentation()->append_segment() );
     } );
+    QObject::connect( button_combine_segments, &QPushButton::clicked, this, [this]
+    {
+        const auto segmentation = _database.segmentation();
+
+        // Operands are the segments of the segmentation and the last image selection
+        struct Operand
+        {
+            QSharedPointer<Segmentation> segmentation;
+            uint32_t segment_number;
+            QString label;
+            QColor color;
+        };
+        auto operands = std::vector<Operand> {};
+        for( uint32_t segment_number = 0; segment_number < segmentation->segment_count(); ++segment_number )
+        {
+            const auto segment = segmentation->segment( segment_number );
+            operands.push_back( { segmentation, segment_number, segment_number ? segment->identifier() : QString { "Unassigned" }, segment->color().qcolor() } );
+        }
+        if( !_database.selection().empty() )
+        {
+            operands.push_back( { nullptr, 0, "Selection", QColor { 200, 200, 200 } } );
+        }
+
+        const auto create_segment_combobox = [&operands]
+        {
+            auto combobox = new QComboBox {};
+            for( size_t operand_index = 0; operand_index < operands.size(); ++operand_index )
+            {
+                auto pixmap = QPixmap { 16, 16 };
+                pixmap.fill( operands[operand_index].color );
+                combobox->addItem( QIcon { pixmap }, operands[operand_index].label, static_cast<int>( operand_index ) );
+            }
+            return combobox;
+        };
+        const auto operand_mask = [this, &operands] ( const QComboBox* combobox )
+        {
+            const auto& operand = operands[combobox->currentData().toInt()];
+            return operand.segmentation ? operand.segmentation->segment_mask( operand.segment_number ) : _database.selection();
+        };
+
+        auto combobox_first = create_segment_combobox();
+        auto combobox_second = create_segment_combobox();
+
+        auto combobox_operation = new QComboBox {};
+        combobox_operation->addItems( { "Union", "Intersection", "Difference", "Complement" } );
+
+        auto button_combine = new QPushButton { "Create Segment" };
+
+        auto layout = new QVBoxLayout {};
+        layout->setContentsMargins( 10, 10, 10, 10 );
+        layout->setSpacing( 10 );
+
+        layout->addWidget( combobox_first );
+        layout->addWidget( combobox_operation );
+        layout->addWidget( combobox_second );
+        layout->addWidget( button_combine );
+
+        auto dialog = QDialog {};
+        dialog.setWindowTitle( "Combine Segments..." );
+        dialog.setLayout( layout );
+
+        QObject::connect( combobox_operation, &QComboBox::currentIndexChanged, &dialog, [combobox_second] ( int index )
+        {
+            combobox_second->setEnabled( index != 3 );
+        } );
+        QObject::connect( button_combine, &QPushButton::clicked, this, [&]
+        {
+            const auto first = operand_mask( combobox_first );
+            const auto second = operand_mask( combobox_second );
+
+            auto mask = SegmentMask {};
+            switch( combobox_operation->currentIndex() )
+            {
+            case 0: mask = first | second; break;
+            case 1: mask = first & second; break;
+            case 2: mask = first - second; break;
+            default: mask = first.complement( segmentation->element_count() ); break;
+            }
+
+            if( mask.empty() )
+            {
+                QMessageBox::information( &dialog, "Combine Segments...", "The combined segment would be empty." );
+                return;
+            }
+
+            auto target_segment = segmentation->append_segment();
+            {
+                auto editor = segmentation->editor();
+                mask.for_each( [&editor, segment_number = target_segment->number()] ( uint32_t element_index )
+                {
+                    editor.update_value( element_index, segment_number );
+                } );
+            }
+            _database.update_active_segment( target_segment );
+
+            dialog.accept();
+        } );
+
+        dialog.exec();
+    } );
+    QObject::connect( button_remove_empty_segments, &QPushButton::clicked, this, [this]
+    {
+        _database.segmentation()->compact_segments();
+    } );
     QObject::connect( button_merge_segments, &QPushButton::clicked, this, [this]
     {
         const auto segmentation = _database.segmentation();
@@ -224,44 +322,20 @@ SegmentationManager::SegmentationManager( Database& database ) : QDialog {}, _da
 
         QObject::connect( button_merge, &QPushButton::clicked, this, [&]
         {
-            auto source_segment_numbers = std::vector<uint32_t> {};
+            auto source_segments = std::vector<QSharedPointer<Segment>> {};
             for( const auto item : segments_list->selectedItems() )
             {
-                source_segment_numbers.push_back( item->data( Qt::UserRole ).toUInt() );
+                source_segments.push_back( segmentation->segment( item->data( Qt::UserRole ).toUInt() ) );
             }
 
-            if( source_segment_numbers.size() < 2 )
+            if( source_segments.size() < 2 )
             {
                 QMessageBox::warning( &dialog, "Merge Segments...", "Please select at least two segments to merge." );
                 return;
             }
 
-            std::sort( source_segment_numbers.begin(), source_segment_numbers.end() );
-
             auto target_segment = segmentation->append_segment();
-            const auto target_segment_number = target_segment->number();
-            {
-                auto editor = segmentation->editor();
-                for( uint32_t element_index = 0; element_index < segmentation->element_count(); ++element_index )
-                {
-                    const auto segment_number = segmentation->segment_number( element_index );
-
-                    auto contained = false;
-                    for( const auto source_segment_number : source_segment_numbers )
-                    {
-                        if( segmentation->segment_number( element_index ) == source_segment_number )
-                        {
-                            editor.update_value( element_index, target_segment_number );
-                            break;
-                        }
-                    }
-                }
-            }
-
-            for( size_t i = source_segment_numbers.size(); i-- > 0; )
-            {
-                segmentation->remove_segment( segmentation->segment( source_segment_numbers[i] ) );
-            }
+            segmentation->merge_segments( source_segments, target_segment );
 
             _database.update_active_segment( target_segment );
 
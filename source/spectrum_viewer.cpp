@@ -975,15 +975,17 @@ void SpectrumViewer::compute_similarity_dataset( const std::vector<ImportedSpect
         const auto channel_count = dataset->channel_count();
         const auto spectra_count = static_cast<uint32_t>( reference_spectra.size() );
 
-        auto indices = std::vector<uint32_t> {};
+        auto all_indices = std::vector<uint32_t> {};
+        auto indices = std::span<const uint32_t> {};
         if( const auto segment = segment_selector->selected_segment() )
         {
-            indices = segmentation->element_indices()[segment->number()];
+            indices = segmentation->element_indices().group( segment->number() );
         }
         else
         {
-            indices.resize( element_count );
-            std::iota( indices.begin(), indices.end(), 0 );
+            all_indices.resize( element_count );
+            std::iota( all_indices.begin(), all_indices.end(), 0 );
+            indices = all_indices;
         }
 
         auto similarities = Matrix<float> { { element_count, spectra_count }, 0.0f };
@@ -0,0 +1,102 @@
+#include "statistics.hpp"
+
+#include "segmentation.hpp"
+
+namespace
+{
+    void compute_group_statistics( double* begin, double* end, GroupStatistics& statistics )
+    {
+        const auto element_count = static_cast<size_t>( end - begin );
+        statistics.element_count = static_cast<uint32_t>( element_count );
+        if( element_count == 0 )
+        {
+            return;
+        }
+
+        auto minimum = std::numeric_limits<double>::max();
+        auto maximum = std::numeric_limits<double>::lowest();
+        auto sum = 0.0;
+        for( auto value = begin; value != end; ++value )
+        {
+            minimum = std::min( minimum, *value );
+            maximum = std::max( maximum, *value );
+            sum += *value;
+        }
+
+        const auto average = sum / element_count;
+        auto squared_deviations = 0.0;
+        for( auto value = begin; value != end; ++value )
+        {
+            const auto deviation = *value - average;
+            squared_deviations += deviation * deviation;
+        }
+
+        // Quantiles are selected in ascending order, each selection only has to partition the range above the previous one
+        auto first = begin;
+        const auto compute_quantile = [&] ( double quantile )
+        {
+            const auto position = ( element_count - 1 ) * quantile;
+            const auto lower_index = static_cast<size_t>( std::floor( position ) );
+            const auto upper_index = static_cast<size_t>( std::ceil( position ) );
+
+            const auto nth = begin + lower_index;
+            std::nth_element( first, nth, end );
+            first = nth;
+
+            const auto lower_value = *nth;
+            if( lower_index == upper_index )
+            {
+                return lower_value;
+            }
+
+            const auto upper_value = *std::min_element( nth + 1, end );
+            return lower_value + ( position - lower_index ) * ( upper_value - lower_value );
+        };
+
+        statistics.minimum = minimum;
+        statistics.maximum = maximum;
+        statistics.average = average;
+        statistics.standard_deviation = std::sqrt( squared_deviations / element_count );
+        statistics.lower_quartile = compute_quantile( 0.25 );
+        statistics.median = compute_quantile( 0.5 );
+        statistics.upper_quartile = compute_quantile( 0.75 );
+    }
+}
+
+namespace statistics
+{
+    Array<GroupStatistics> compute_grouped_statistics( const Feature::Values& values, const Array<uint32_t>& group_numbers, uint32_t group_count )
+    {
+        const auto element_count = std::min( std::visit( [] ( const auto& values ) { return values.size(); }, values ), group_numbers.size() );
+        return compute_grouped_statistics( values, GroupedIndices::from_group_numbers( std::span { group_numbers.data(), element_count }, group_count ) );
+    }
+    Array<GroupStatistics> compute_grouped_statistics( const Feature::Values& values, const GroupedIndices& groups )
+    {
+        const auto group_count = groups.group_count();
+        auto statistics = Array<GroupStatistics> { group_count, GroupStatistics {} };
+
+        std::visit( [&] ( const auto& values )
+        {
+            auto partitioned = Array<double>::allocate( groups.indices.size() );
+            utility::iterate_parallel( groups.indices.size(), [&] ( size_t position )
+            {
+                partitioned[position] = static_cast<double>( values[groups.indices[position]] );
+            } );
+
+            utility::iterate_parallel( group_count, [&] ( uint32_t group_number )
+            {
+                const auto begin = partitioned.data() + groups.offsets[group_number];
+                const auto end = partitioned.data() + groups.offsets[group_number + 1];
+                compute_group_statistics( begin, end, statistics[group_number] );
+            } );
+        }, values );
+
+        return statistics;
+    }
+
+    Array<GroupStatistics> compute_segment_statistics( const Feature& feature, const Segmentation& segmentation )
+    {
+        Console::info( "statistics::compute_segment_statistics" );
+        return compute_grouped_statistics( feature.values(), segmentation.element_indices() );
+    }
+}
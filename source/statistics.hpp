@@ -0,0 +1,26 @@
+#pragma once
+#include "feature.hpp"
+#include "utility.hpp"
+
+class Segmentation;
+
+// ----- GroupStatistics ----- //
+
+struct GroupStatistics
+{
+    double minimum = 0.0;
+    double maximum = 0.0;
+    double average = 0.0;
+    double standard_deviation = 0.0;
+    double lower_quartile = 0.0;
+    double upper_quartile = 0.0;
+    double median = 0.0;
+    uint32_t element_count = 0;
+};
+
+namespace statistics
+{
+    Array<GroupStatistics> compute_grouped_statistics( const Feature::Values& values, const Array<uint32_t>& group_numbers, uint32_t group_count );
+    Array<GroupStatistics> compute_grouped_statistics( const Feature::Values& values, const GroupedIndices& groups );
+    Array<GroupStatistics> compute_segment_statistics( const Feature& feature, const Segmentation& segmentation );
+}
@@ -2,6 +2,9 @@
 
 #include <numbers>
 #include <limits>
+#include <thread>
+
+#include <qcoreapplication.h>
 
 namespace utility
 {
@@ -33,6 +36,45 @@ namespace utility
         }
         return precision;
     }
+
+    QByteArray compress_runs( std::span<const uint32_t> values )
+    {
+        auto runs = std::vector<uint32_t> {};
+        for( size_t index = 0; index < values.size(); )
+        {
+            const auto value = values[index];
+            auto length = uint32_t { 1 };
+            while( index + length < values.size() && values[index + length] == value && length < std::numeric_limits<uint32_t>::max() )
+            {
+                ++length;
+            }
+            runs.push_back( value );
+            runs.push_back( length );
+            index += length;
+        }
+        return qCompress( reinterpret_cast<const uchar*>( runs.data() ), static_cast<qsizetype>( runs.size() * sizeof( uint32_t ) ) );
+    }
+    bool decompress_runs( const QByteArray& bytes, std::span<uint32_t> values )
+    {
+        const auto runs_bytes = qUncompress( bytes );
+        const auto runs = std::span { reinterpret_cast<const uint32_t*>( runs_bytes.constData() ), runs_bytes.size() / sizeof( uint32_t ) };
+        if( runs.size() % 2 )
+        {
+            return false;
+        }
+
+        auto index = size_t { 0 };
+        for( size_t run = 0; run < runs.size(); run += 2 )
+        {
+            if( index + runs[run + 1] > values.size() )
+            {
+                return false;
+            }
+            std::fill_n( values.begin() + index, runs[run + 1], runs[run] );
+            index += runs[run + 1];
+        }
+        return index == values.size();
+    }
 }
 
 // ----- Timer ----- //
@@ -51,3 +93,242 @@ void Timer::reset()
 {
     _start = std::chrono::high_resolution_clock::now();
 }
+
+// ----- Computed ----- //
+
+ComputedObject::~ComputedObject()
+{
+    this->uncache();
+}
+
+bool ComputedObject::resident() const noexcept
+{
+    return _residency_count > 0;
+}
+void ComputedObject::acquire_residency() const noexcept
+{
+    ++_residency_count;
+}
+void ComputedObject::release_residency() const noexcept
+{
+    if( _residency_count > 0 )
+    {
+        --_residency_count;
+    }
+}
+
+void ComputedObject::cache( size_t bytes, bool recomputable ) const
+{
+    _last_access = CacheManager::instance().tick();
+    CacheManager::instance().insert( this, bytes, recomputable );
+}
+void ComputedObject::uncache() const
+{
+    CacheManager::instance().remove( this );
+}
+void ComputedObject::touch() const noexcept
+{
+    _last_access = CacheManager::instance().tick();
+}
+
+// ----- CacheManager ----- //
+
+CacheManager& CacheManager::instance()
+{
+    static auto cache_manager = new CacheManager {};
+    return *cache_manager;
+}
+
+CacheManager::CacheManager()
+{
+    auto memory_status = MEMORYSTATUSEX {};
+    memory_status.dwLength = sizeof( memory_status );
+    if( GlobalMemoryStatusEx( &memory_status ) )
+    {
+        _physical_memory = static_cast<size_t>( memory_status.ullTotalPhys );
+        _budget = static_cast<size_t>( _physical_memory * config::cache_budget_fraction );
+    }
+    else
+    {
+        _budget = std::numeric_limits<size_t>::max();
+    }
+}
+
+size_t CacheManager::physical_memory() const noexcept
+{
+    return _physical_memory;
+}
+size_t CacheManager::budget() const noexcept
+{
+    return _budget;
+}
+void CacheManager::update_budget( size_t budget )
+{
+    _budget = budget;
+    this->request_eviction();
+}
+size_t CacheManager::usage() const noexcept
+{
+    return _usage;
+}
+
+void CacheManager::insert( const ComputedObject* object, size_t bytes, bool recomputable )
+{
+    auto& entry = _entries[object];
+    _usage = _usage - entry.bytes + bytes;
+    entry = Entry { bytes, recomputable };
+
+    if( _usage > _budget )
+    {
+        this->request_eviction();
+    }
+}
+void CacheManager::remove( const ComputedObject* object )
+{
+    if( const auto iterator = _entries.find( object ); iterator != _entries.end() )
+    {
+        _usage -= iterator->second.bytes;
+        _entries.erase( iterator );
+    }
+}
+uint64_t CacheManager::tick() noexcept
+{
+    return ++_clock;
+}
+
+void CacheManager::request_eviction()
+{
+    // Values may still be referenced by the computation that triggered the insertion, defer to the event loop
+    if( const auto application = QCoreApplication::instance(); application && !_eviction_requested )
+    {
+        _eviction_requested = true;
+        QMetaObject::invokeMethod( application, [this] { this->evict(); }, Qt::QueuedConnection );
+    }
+}
+void CacheManager::evict()
+{
+    _eviction_requested = false;
+    if( _usage <= _budget )
+    {
+        return;
+    }
+
+    auto candidates = std::vector<const ComputedObject*> {};
+    for( const auto& [object, entry] : _entries )
+    {
+        if( entry.recomputable && !object->resident() )
+        {
+            candidates.push_back( object );
+        }
+    }
+    std::sort( candidates.begin(), candidates.end(), [] ( const ComputedObject* a, const ComputedObject* b )
+    {
+        return a->_last_access < b->_last_access;
+    } );
+
+    const auto previous_usage = _usage;
+    auto evicted_count = size_t { 0 };
+    for( const auto object : candidates )
+    {
+        if( _usage <= _budget )
+        {
+            break;
+        }
+
+        this->remove( object );
+        object->evict();
+        ++evicted_count;
+    }
+
+    Console::info( std::format( "CacheManager::evict: evicted {} values, {} MB -> {} MB (budget {} MB)", evicted_count, previous_usage >> 20, _usage >> 20, _budget >> 20 ) );
+}
+
+// ----- CacheResidency ----- //
+
+CacheResidency::CacheResidency( const ComputedObject* object ) noexcept
+{
+    this->reset( object );
+}
+CacheResidency::~CacheResidency()
+{
+    this->reset();
+}
+
+void CacheResidency::reset( const ComputedObject* object ) noexcept
+{
+    if( _object != object )
+    {
+        if( _object )
+        {
+            _object->release_residency();
+        }
+        if( _object = object )
+        {
+            object->acquire_residency();
+        }
+    }
+}
+
+
+// ----- GroupedIndices ----- //
+
+GroupedIndices GroupedIndices::from_group_numbers( std::span<const uint32_t> group_numbers, uint32_t group_count )
+{
+    constexpr auto minimum_chunk_size = uint32_t { 1 << 16 };
+
+    const auto element_count = static_cast<uint32_t>( group_numbers.size() );
+    if( group_count == 0 )
+    {
+        return GroupedIndices { .indices = Array<uint32_t> {}, .offsets = Array<uint32_t> { 1, 0 } };
+    }
+
+    const auto chunk_count = std::clamp( element_count / minimum_chunk_size, 1u, std::max( std::thread::hardware_concurrency(), 1u ) );
+    const auto chunk_size = ( element_count + chunk_count - 1 ) / chunk_count;
+
+    const auto chunk_range = [=] ( uint32_t chunk_index )
+    {
+        const auto begin = std::min( chunk_index * chunk_size, element_count );
+        return std::pair { begin, std::min( begin + chunk_size, element_count ) };
+    };
+
+    // Two-pass counting sort, the per-chunk counts become per-chunk write cursors so chunks scatter independently
+    auto cursors = Array<uint32_t> { size_t { chunk_count } * group_count, 0 };
+    utility::iterate_parallel( chunk_count, [&] ( uint32_t chunk_index )
+    {
+        const auto [begin, end] = chunk_range( chunk_index );
+        const auto chunk_cursors = cursors.data() + size_t { chunk_index } * group_count;
+        for( uint32_t element_index = begin; element_index < end; ++element_index )
+        {
+            ++chunk_cursors[group_numbers[element_index]];
+        }
+    } );
+
+    auto grouped_indices = GroupedIndices {
+        .indices = Array<uint32_t>::allocate( element_count ),
+        .offsets = Array<uint32_t> { size_t { group_count } + 1, 0 }
+    };
+
+    auto offset = uint32_t { 0 };
+    for( uint32_t group_number = 0; group_number < group_count; ++group_number )
+    {
+        grouped_indices.offsets[group_number] = offset;
+        for( uint32_t chunk_index = 0; chunk_index < chunk_count; ++chunk_index )
+        {
+            auto& cursor = cursors[size_t { chunk_index } * group_count + group_number];
+            offset += std::exchange( cursor, offset );
+        }
+    }
+    grouped_indices.offsets[group_count] = offset;
+
+    utility::iterate_parallel( chunk_count, [&] ( uint32_t chunk_index )
+    {
+        const auto [begin, end] = chunk_range( chunk_index );
+        const auto chunk_cursors = cursors.data() + size_t { chunk_index } * group_count;
+        for( uint32_t element_index = begin; element_index < end; ++element_index )
+        {
+            grouped_indices.indices[chunk_cursors[group_numbers[element_index]]++] = element_index;
+        }
+    } );
+
+    return grouped_indices;
+}
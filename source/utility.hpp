@@ -10,15 +10,22 @@
 #include <execution>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <ranges>
+#include <span>
 #include <sstream>
+#include <unordered_map>
+#include <variant>
 
 #define NOMINMAX
 #include <Windows.h>
 
+#include <qbytearray.h>
 #include <qcolor.h>
+#include <qimage.h>
 #include <qstring.h>
 #include <qobject.h>
+#include <qpointer.h>
 
 namespace utility
 {
@@ -28,6 +35,10 @@ namespace utility
     int stepsize_to_precision( double stepsize );
     int compute_precision( double value );
 
+    // Run-length encodes the values as (value, length) pairs and deflates the result
+    QByteArray compress_runs( std::span<const uint32_t> values );
+    bool decompress_runs( const QByteArray& bytes, std::span<uint32_t> values );
+
     template<class T, class IndexType>
     void apply_permutation( T* begin, T* end, const IndexType* permutation )
     {
@@ -54,10 +65,11 @@ namespace utility
         }
     }
 
+    // Invokes the callable concurrently for every index, iterations must not write to shared state
     template<class IndexType> void iterate_parallel( IndexType start, IndexType end, auto&& callable )
     {
         const auto range = std::views::iota( start, end );
-        std::for_each( std::execution::seq, range.begin(), range.end(), std::forward<decltype( callable )>( callable ) );
+        std::for_each( std::execution::par, range.begin(), range.end(), std::forward<decltype( callable )>( callable ) );
     }
     template<class IndexType> void iterate_parallel( IndexType end, auto&& callable )
     {
@@ -71,6 +83,60 @@ namespace concepts
     {
         { a != b } -> std::convertible_to<bool>;
     };
+
+    template<class T> concept Container = requires( const T& container )
+    {
+        container.begin();
+        container.end();
+        { container.size() } -> std::convertible_to<size_t>;
+    };
+
+    template<class T> concept ByteSized = requires( const T& value )
+    {
+        { value.bytes() } -> std::convertible_to<size_t>;
+    };
+
+    template<class T> struct is_variant : std::false_type {};
+    template<class... Types> struct is_variant<std::variant<Types...>> : std::true_type {};
+    template<class T> concept Variant = is_variant<T>::value;
+}
+
+namespace utility
+{
+    template<class T> size_t estimate_bytes( const T& value )
+    {
+        if constexpr( concepts::Variant<T> )
+        {
+            return std::visit( [] ( const auto& alternative ) { return estimate_bytes( alternative ); }, value );
+        }
+        else if constexpr( concepts::Container<T> )
+        {
+            using element_type = std::remove_cvref_t<decltype( *value.begin() )>;
+
+            auto bytes = sizeof( T );
+            if constexpr( std::is_trivially_copyable_v<element_type> )
+            {
+                bytes += static_cast<size_t>( value.size() ) * sizeof( element_type );
+            }
+            else for( const auto& element : value )
+            {
+                bytes += estimate_bytes( element );
+            }
+            return bytes;
+        }
+        else if constexpr( concepts::ByteSized<T> )
+        {
+            return sizeof( T ) + static_cast<size_t>( value.bytes() );
+        }
+        else if constexpr( std::same_as<T, QImage> )
+        {
+            return sizeof( T ) + static_cast<size_t>( value.sizeInBytes() );
+        }
+        else
+        {
+            return sizeof( T );
+        }
+    }
 }
 
 // ----- Formatters ----- //
@@ -550,10 +616,78 @@ class ComputedObject : public QObject
 {
     Q_OBJECT
 public:
+    ComputedObject() noexcept = default;
+    ~ComputedObject();
+
     virtual void invalidate() = 0;
 
+    bool resident() const noexcept;
+    void acquire_residency() const noexcept;
+    void release_residency() const noexcept;
+
 signals:
     void changed() const;
+
+protected:
+    friend class CacheManager;
+
+    virtual void evict() const noexcept = 0;
+
+    void cache( size_t bytes, bool recomputable ) const;
+    void uncache() const;
+    void touch() const noexcept;
+
+    mutable uint64_t _last_access = 0;
+    mutable uint32_t _residency_count = 0;
+};
+
+class CacheManager
+{
+public:
+    static CacheManager& instance();
+
+    size_t physical_memory() const noexcept;
+    size_t budget() const noexcept;
+    void update_budget( size_t budget );
+    size_t usage() const noexcept;
+
+    void insert( const ComputedObject* object, size_t bytes, bool recomputable );
+    void remove( const ComputedObject* object );
+    uint64_t tick() noexcept;
+
+private:
+    struct Entry
+    {
+        size_t bytes;
+        bool recomputable;
+    };
+
+    CacheManager();
+
+    void request_eviction();
+    void evict();
+
+    std::unordered_map<const ComputedObject*, Entry> _entries;
+    size_t _physical_memory = 0;
+    size_t _budget = 0;
+    size_t _usage = 0;
+    uint64_t _clock = 0;
+    bool _eviction_requested = false;
+};
+
+class CacheResidency
+{
+public:
+    CacheResidency() noexcept = default;
+    CacheResidency( const ComputedObject* object ) noexcept;
+    CacheResidency( const CacheResidency& ) = delete;
+    CacheResidency& operator=( const CacheResidency& ) = delete;
+    ~CacheResidency();
+
+    void reset( const ComputedObject* object = nullptr ) noexcept;
+
+private:
+    QPointer<const ComputedObject> _object;
 };
 
 template<class T> class Computed : public ComputedObject
@@ -593,6 +727,11 @@ public:
             }
 
             _value = _compute_function();
+            this->cache( utility::estimate_bytes( *_value ), true );
+        }
+        else
+        {
+            this->touch();
         }
         return *_value;
     }
@@ -607,19 +746,40 @@ public:
 
     void invalidate()
     {
+        this->uncache();
         _value.reset();
         emit ComputedObject::changed();
     }
     void write( const value_type& value )
     {
         _value = value;
+        this->cache( utility::estimate_bytes( *_value ), false );
         emit ComputedObject::changed();
     }
     void write( value_type&& value )
     {
         _value = std::move( value );
+        this->cache( utility::estimate_bytes( *_value ), false );
         emit ComputedObject::changed();
     }
+    bool modify( auto&& callable )
+    {
+        // Updates a present value in place, absent values are left to be computed on demand
+        if( !_value.has_value() )
+        {
+            return false;
+        }
+        callable( *_value );
+        this->touch();
+        emit ComputedObject::changed();
+        return true;
+    }
+
+protected:
+    void evict() const noexcept override
+    {
+        _value.reset();
+    }
 
 private:
     mutable std::optional<value_type> _value;
@@ -662,3 +822,32 @@ template<class T> struct Range
         return lower != other.lower || upper != other.upper;
     }
 };
+
+
+// ----- GroupedIndices ----- //
+
+// Indices grouped in a single array, the indices of group g are stored in ascending order at [offsets[g], offsets[g + 1])
+struct GroupedIndices
+{
+    static GroupedIndices from_group_numbers( std::span<const uint32_t> group_numbers, uint32_t group_count );
+
+    uint32_t group_count() const noexcept
+    {
+        return offsets.empty() ? 0 : static_cast<uint32_t>( offsets.size() - 1 );
+    }
+    std::span<const uint32_t> group( uint32_t group_number ) const
+    {
+        return std::span<const uint32_t> { indices.data() + offsets[group_number], indices.data() + offsets[group_number + 1] };
+    }
+    std::span<const uint32_t> operator[]( uint32_t group_number ) const
+    {
+        return this->group( group_number );
+    }
+    size_t bytes() const noexcept
+    {
+        return indices.bytes() + offsets.bytes();
+    }
+
+    Array<uint32_t> indices;
+    Array<uint32_t> offsets;
+};
@@ -9,9 +9,11 @@
 #include "embedding_viewer.hpp"
 #include "histogram_viewer.hpp"
 #include "image_viewer.hpp"
+#include "scatter_viewer.hpp"
 #include "spectrum_viewer.hpp"
 
 #include <qlayout.h>
+#include <qshortcut.h>
 #include <qsplitter.h>
 #include <qstackedlayout.h>
 #include <qtabwidget.h>
@@ -28,6 +30,7 @@ Workspace::Workspace( Database& database ) : _database { database }
         _embedding_viewer = new EmbeddingViewer { database };
         _histogram_viewer = new HistogramViewer { database };
         _image_viewer = new ImageViewer { database };
+        _scatter_viewer = new ScatterViewer { database };
         _spectrum_viewer = new SpectrumViewer { database };
 
         Console::info( "Initializing workspace layout..." );
@@ -47,8 +50,12 @@ Workspace::Workspace( Database& database ) : _database { database }
         //histogram_viewer_layout->addWidget( histogram_feature_selector, 0, Qt::AlignCenter );
         //histogram_viewer_layout->addWidget( _histogram_viewer, 1 );
 
+        auto histogram_tabwidget = new QTabWidget {};
+        histogram_tabwidget->addTab( _histogram_viewer, "Histogram" );
+        histogram_tabwidget->addTab( _scatter_viewer, "Scatter" );
+
         auto splitter_histogram_boxplot = new QSplitter { Qt::Vertical };
-        splitter_histogram_boxplot->addWidget( _histogram_viewer );
+        splitter_histogram_boxplot->addWidget( histogram_tabwidget );
         splitter_histogram_boxplot->addWidget( _boxplot_viewer );
         splitter_histogram_boxplot->setSizes( { 10000, 10000 } );
 
@@ -97,6 +104,12 @@ Workspace::Workspace( Database& database ) : _database { database }
                 {
                     _histogram_viewer->update_feature( feature );
                     _boxplot_viewer->update_feature( feature );
+                    _scatter_viewer->update_xfeature( feature );
+                    _scatter_viewer->update_yfeature( feature );
+                }
+                else if( _database.features()->object_count() == 2 )
+                {
+                    _scatter_viewer->update_yfeature( feature );
                 }
             }
         } );
@@ -108,12 +121,17 @@ Workspace::Workspace( Database& database ) : _database { database }
         _embedding_viewer = new EmbeddingViewer { database };
         _histogram_viewer = new HistogramViewer { database };
         // _image_viewer = new ImageViewer { database };
+        _scatter_viewer = new ScatterViewer { database };
         _spectrum_viewer = new SpectrumViewer { database };
 
         Console::info( "Initializing workspace layout..." );
+        auto histogram_tabwidget = new QTabWidget {};
+        histogram_tabwidget->addTab( _histogram_viewer, "Histogram" );
+        histogram_tabwidget->addTab( _scatter_viewer, "Scatter" );
+
         auto splitter_embedding_histogram_boxplot = new QSplitter { Qt::Horizontal };
         splitter_embedding_histogram_boxplot->addWidget( _embedding_viewer );
-        splitter_embedding_histogram_boxplot->addWidget( _histogram_viewer );
+        splitter_embedding_histogram_boxplot->addWidget( histogram_tabwidget );
         splitter_embedding_histogram_boxplot->addWidget( _boxplot_viewer );
         splitter_embedding_histogram_boxplot->setSizes( { 10000, 10000, 10000 } );
 
@@ -138,11 +156,22 @@ Workspace::Workspace( Database& database ) : _database { database }
                 {
                     _histogram_viewer->update_feature( feature );
                     _boxplot_viewer->update_feature( feature );
+                    _scatter_viewer->update_xfeature( feature );
+                    _scatter_viewer->update_yfeature( feature );
+                }
+                else if( _database.features()->object_count() == 2 )
+                {
+                    _scatter_viewer->update_yfeature( feature );
                 }
             }
         } );
     }
 
+    // Segmentation history shortcuts
+    const auto segmentation = _database.segmentation();
+    QObject::connect( new QShortcut { QKeySequence::Undo, this }, &QShortcut::activated, segmentation.get(), &Segmentation::undo );
+    QObject::connect( new QShortcut { QKeySequence::Redo, this }, &QShortcut::activated, segmentation.get(), &Segmentation::redo );
+
     // Trigger computations
     emit dataset->intensities_changed();
 
@@ -9,6 +9,7 @@ class ColormapViewer;
 class EmbeddingViewer;
 class HistogramViewer;
 class ImageViewer;
+class ScatterViewer;
 class SpectrumViewer;
 
 class Workspace : public QWidget
@@ -31,5 +32,6 @@ private:
     EmbeddingViewer* _embedding_viewer = nullptr;
     HistogramViewer* _histogram_viewer = nullptr;
     ImageViewer* _image_viewer = nullptr;
+    ScatterViewer* _scatter_viewer = nullptr;
     SpectrumViewer* _spectrum_viewer = nullptr;
 };
\ No newline at end of file